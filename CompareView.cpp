@@ -0,0 +1,71 @@
+#include "CompareView.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <algorithm>
+
+CompareView::CompareView(QWidget *parent) : QWidget(parent), split(0.5)
+{
+    setCursor(Qt::SplitHCursor);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void CompareView::setBefore(const QPixmap &pixmap)
+{
+    before = pixmap;
+    update();
+}
+
+void CompareView::setAfter(const QPixmap &pixmap)
+{
+    after = pixmap;
+    update();
+}
+
+// centre a pixmap in the widget at its native (already fitted) size
+QRect CompareView::placed(const QPixmap &pixmap) const
+{
+    QSize size = pixmap.size() / pixmap.devicePixelRatio();
+    return QRect(QPoint((width() - size.width()) / 2, (height() - size.height()) / 2), size);
+}
+
+void CompareView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(30, 30, 30));
+
+    int x = static_cast<int>(split * width());
+
+    painter.save();
+    painter.setClipRect(0, 0, x, height());
+    painter.drawPixmap(placed(before), before);
+    painter.restore();
+
+    painter.save();
+    painter.setClipRect(x, 0, width() - x, height());
+    painter.drawPixmap(placed(after), after);
+    painter.restore();
+
+    painter.setPen(QPen(Qt::white, 2));
+    painter.drawLine(x, 0, x, height());
+    painter.drawText(QRect(0, 8, x - 8, 20), Qt::AlignRight, "Before");
+    painter.drawText(QRect(x + 8, 8, width() - x - 8, 20), Qt::AlignLeft, "After");
+}
+
+void CompareView::mousePressEvent(QMouseEvent *event)
+{
+    moveDivider(event->position().toPoint().x());
+}
+
+void CompareView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton)
+        moveDivider(event->position().toPoint().x());
+}
+
+void CompareView::moveDivider(int x)
+{
+    if (width() <= 0)
+        return;
+    split = std::clamp(static_cast<double>(x) / width(), 0.0, 1.0);
+    update();
+}
@@ -0,0 +1,31 @@
+#ifndef COMPARE_VIEW_H
+#define COMPARE_VIEW_H
+
+#include <QWidget>
+#include <QPixmap>
+
+// Before/after overlay with a draggable divider. Both sides are display-sized
+// pixmaps supplied by the owner; dragging only repaints.
+class CompareView : public QWidget {
+public:
+    explicit CompareView(QWidget *parent = nullptr);
+
+    void setBefore(const QPixmap& pixmap);
+    void setAfter(const QPixmap& pixmap);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    void moveDivider(int x);
+    QRect placed(const QPixmap& pixmap) const;
+
+    QPixmap before;
+    QPixmap after;
+    double split;   // divider position as a fraction of the width
+};
+
+#endif
+//compare view
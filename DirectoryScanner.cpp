@@ -1,15 +1,16 @@
 #include "DirectoryScanner.h"
 #include <algorithm>
 #include <array>
+#include <set>
 
 namespace fs = std::filesystem;
 
-DirectoryScanner::DirectoryScanner() : currentIndex_(-1) {}
+DirectoryScanner::DirectoryScanner() : sortOrder_(SortOrder::Name), currentIndex_(-1) {}
 
 // check if file has a supported image extension
 bool DirectoryScanner::isSupported(const fs::path& path) {
-    static const std::array<std::string_view, 7> supported = {
-        ".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".webp"
+    static const std::array<std::string_view, 8> supported = {
+        ".jpg", ".jpeg", ".png", ".bmp", ".tif", ".tiff", ".webp", ".gif"
     };
     std::string ext = path.extension().string();
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
@@ -26,15 +27,21 @@ bool DirectoryScanner::openDirectory(const fs::path& filepath) {
     if (!fs::exists(filepath)) return false;
     fs::path dir = fs::is_directory(filepath) ? filepath : filepath.parent_path();
 
-    imageFiles.clear();
+    std::vector<fs::path> found;
     for (const auto& entry : fs::directory_iterator(dir)) {
         if (entry.is_regular_file() && isSupported(entry.path())) {
-            imageFiles.push_back(entry.path());
+            found.push_back(entry.path());
         }
     }
 
-    if (imageFiles.empty()) return false;
-    std::sort(imageFiles.begin(), imageFiles.end());
+    if (found.empty()) return false;
+    std::sort(found.begin(), found.end());
+    allFiles = std::move(found);
+
+    // metadata and filters belong to the previous directory; the sort order is kept
+    metadata_.clear();
+    filter_ = Filter();
+    imageFiles = allFiles;
 
     currentIndex_ = 0;
     if (!fs::is_directory(filepath)) {
@@ -43,6 +50,7 @@ bool DirectoryScanner::openDirectory(const fs::path& filepath) {
             currentIndex_ = static_cast<int>(std::distance(imageFiles.begin(), it));
         }
     }
+    applyOrder();
     return true;
 }
 
@@ -64,4 +72,101 @@ fs::path DirectoryScanner::previous() {
 fs::path DirectoryScanner::current() const {
     if (imageFiles.empty() || currentIndex_ < 0) return {};
     return imageFiles[currentIndex_];
+}
+
+fs::path DirectoryScanner::peek(int offset) const {
+    if (imageFiles.empty() || currentIndex_ < 0) return {};
+    int n = static_cast<int>(imageFiles.size());
+    return imageFiles[((currentIndex_ + offset) % n + n) % n];
+}
+
+void DirectoryScanner::setFiles(std::vector<fs::path> files, int index) {
+    imageFiles = std::move(files);
+    if (imageFiles.empty()) {
+        currentIndex_ = -1;
+        return;
+    }
+    currentIndex_ = std::clamp(index, 0, static_cast<int>(imageFiles.size()) - 1);
+}
+
+void DirectoryScanner::setMetadata(const std::vector<ImageMetadata>& metadata) {
+    metadata_.clear();
+    metadata_.reserve(metadata.size());
+    for (const auto& m : metadata) metadata_.emplace(m.path.string(), m);
+    applyOrder();
+}
+
+void DirectoryScanner::setSortOrder(SortOrder order) {
+    sortOrder_ = order;
+    applyOrder();
+}
+
+void DirectoryScanner::setFilter(const Filter& filter) {
+    filter_ = filter;
+    applyOrder();
+}
+
+std::vector<std::string> DirectoryScanner::cameras() const {
+    std::set<std::string> names;
+    for (const auto& [path, m] : metadata_) {
+        if (!m.camera.empty()) names.insert(m.camera);
+    }
+    return {names.begin(), names.end()};
+}
+
+// files without metadata yet are kept so the list never empties while indexing
+bool DirectoryScanner::passesFilter(const fs::path& path) const {
+    auto it = metadata_.find(path.string());
+    if (it == metadata_.end()) return true;
+    const ImageMetadata& m = it->second;
+    if (!filter_.camera.empty() && m.camera != filter_.camera) return false;
+    if (filter_.minMegapixels > 0.0 &&
+        static_cast<double>(m.width) * m.height < filter_.minMegapixels * 1e6) return false;
+    return true;
+}
+
+void DirectoryScanner::applyOrder() {
+    fs::path keep = current();
+
+    imageFiles.clear();
+    for (const auto& f : allFiles) {
+        if (passesFilter(f)) imageFiles.push_back(f);
+    }
+
+    if (sortOrder_ != SortOrder::Name && !metadata_.empty()) {
+        static const ImageMetadata unknown;
+        auto meta = [this](const fs::path& p) -> const ImageMetadata& {
+            auto it = metadata_.find(p.string());
+            return it != metadata_.end() ? it->second : unknown;
+        };
+        // allFiles is name-sorted, so a stable sort breaks ties by name
+        std::stable_sort(imageFiles.begin(), imageFiles.end(),
+                         [&](const fs::path& a, const fs::path& b) {
+            const ImageMetadata& ma = meta(a);
+            const ImageMetadata& mb = meta(b);
+            switch (sortOrder_) {
+            case SortOrder::DateTaken:
+                // images without EXIF dates go to the end
+                if ((ma.dateTaken == 0) != (mb.dateTaken == 0)) return mb.dateTaken == 0;
+                return ma.dateTaken < mb.dateTaken;
+            case SortOrder::Dimensions:
+                return static_cast<long long>(ma.width) * ma.height >
+                       static_cast<long long>(mb.width) * mb.height;
+            case SortOrder::FileSize:
+                return ma.fileSize > mb.fileSize;
+            case SortOrder::Camera:
+                return ma.camera < mb.camera;
+            case SortOrder::Name:
+                break;
+            }
+            return false;
+        });
+    }
+
+    if (imageFiles.empty()) {
+        currentIndex_ = -1;
+        return;
+    }
+    auto it = std::find(imageFiles.begin(), imageFiles.end(), keep);
+    currentIndex_ = it != imageFiles.end() ? static_cast<int>(std::distance(imageFiles.begin(), it)) : 0;
 }
\ No newline at end of file
@@ -4,19 +4,52 @@
 #include <vector>
 #include <filesystem>
 #include <string>
+#include <unordered_map>
+#include "MetadataIndex.h"
 
 // Scans a directory for supported image files and provides nav
 class DirectoryScanner {
 public:
+    enum class SortOrder { Name, DateTaken, Dimensions, FileSize, Camera };
+
+    // empty camera / zero megapixels means no restriction
+    struct Filter {
+        std::string camera;
+        double minMegapixels = 0.0;
+    };
+
     DirectoryScanner();
     bool openDirectory(const std::filesystem::path& filepath);
     std::filesystem::path next();
     std::filesystem::path previous();
     std::filesystem::path current() const;
+    // file `offset` steps from the current one (wrapping), without moving
+    std::filesystem::path peek(int offset) const;
+
+    const std::vector<std::filesystem::path>& files() const { return imageFiles; }
+    // replace the navigation list (e.g. with duplicate groups) and jump to index
+    void setFiles(std::vector<std::filesystem::path> files, int index = 0);
+
+    // attach index results for the open directory; reapplies sort and filter
+    void setMetadata(const std::vector<ImageMetadata>& metadata);
+    void setSortOrder(SortOrder order);
+    void setFilter(const Filter& filter);
+    SortOrder sortOrder() const { return sortOrder_; }
+    const Filter& filter() const { return filter_; }
+    // distinct camera names seen in the directory, sorted
+    std::vector<std::string> cameras() const;
 
 private:
-    std::vector<std::filesystem::path> imageFiles;
+    std::vector<std::filesystem::path> allFiles;    // full listing, by name
+    std::vector<std::filesystem::path> imageFiles;  // navigation order after sort/filter
+    std::unordered_map<std::string, ImageMetadata> metadata_;
+    SortOrder sortOrder_;
+    Filter filter_;
     int currentIndex_;
+
+    // rebuild imageFiles from allFiles, keeping the current file selected
+    void applyOrder();
+    bool passesFilter(const std::filesystem::path& path) const;
     //returns true for recognized image file extensions.
     bool isSupported(const std::filesystem::path& path);
 };
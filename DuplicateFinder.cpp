@@ -0,0 +1,240 @@
+#include "DuplicateFinder.h"
+#include "IndexCache.h"
+#include "ImageLoader.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <bitset>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kIndexMagic = 0x44564950; // "PIVD"
+constexpr uint32_t kIndexVersion = 2;
+
+struct CachedHash {
+    long long mtime;
+    uint64_t hash;
+    uint8_t hashable;   // 0 if the file could not be decoded at this mtime
+};
+
+using HashIndex = std::unordered_map<std::string, CachedHash>;
+
+int hamming(uint64_t a, uint64_t b) {
+    return static_cast<int>(std::bitset<64>(a ^ b).count());
+}
+
+// On-disk layout: magic, version, count, then per entry
+// name length (u16), name bytes, mtime (i64), hash (u64), hashable (u8).
+HashIndex readIndex(const fs::path& file) {
+    HashIndex index;
+    std::ifstream in(file, std::ios::binary);
+    uint32_t count = 0;
+    constexpr size_t kMinEntry = sizeof(uint16_t) + sizeof(long long) + sizeof(uint64_t) + sizeof(uint8_t);
+    if (!in || !IndexCache::readHeader(in, kIndexMagic, kIndexVersion, kMinEntry, count)) return index;
+
+    index.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint16_t len = 0;
+        in.read(reinterpret_cast<char*>(&len), sizeof(len));
+        std::string name(len, '\0');
+        in.read(name.data(), len);
+        CachedHash entry{};
+        in.read(reinterpret_cast<char*>(&entry.mtime), sizeof(entry.mtime));
+        in.read(reinterpret_cast<char*>(&entry.hash), sizeof(entry.hash));
+        in.read(reinterpret_cast<char*>(&entry.hashable), sizeof(entry.hashable));
+        if (!in) return {}; // truncated file, treat as no cache
+        index.emplace(std::move(name), entry);
+    }
+    return index;
+}
+
+void writeIndex(const fs::path& file, const HashIndex& index) {
+    IndexCache::write(file, kIndexMagic, kIndexVersion, static_cast<uint32_t>(index.size()),
+                      [&index](std::ofstream& out) {
+        for (const auto& [name, entry] : index) {
+            uint16_t len = static_cast<uint16_t>(name.size());
+            out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+            out.write(name.data(), len);
+            out.write(reinterpret_cast<const char*>(&entry.mtime), sizeof(entry.mtime));
+            out.write(reinterpret_cast<const char*>(&entry.hash), sizeof(entry.hash));
+            out.write(reinterpret_cast<const char*>(&entry.hashable), sizeof(entry.hashable));
+        }
+    });
+}
+
+// BK-tree over Hamming distance. A query only descends into children whose
+// edge distance lies within [d - radius, d + radius], so finding neighbours
+// costs far less than comparing every pair.
+class BKTree {
+public:
+    void insert(uint64_t hash, int item) {
+        if (nodes.empty()) {
+            nodes.push_back({hash, {item}, {}});
+            return;
+        }
+        int cur = 0;
+        while (true) {
+            int d = hamming(hash, nodes[cur].hash);
+            if (d == 0) {
+                nodes[cur].items.push_back(item);
+                return;
+            }
+            auto& children = nodes[cur].children;
+            auto it = std::find_if(children.begin(), children.end(),
+                                   [d](const auto& c) { return c.first == d; });
+            if (it == children.end()) {
+                children.emplace_back(d, static_cast<int>(nodes.size()));
+                nodes.push_back({hash, {item}, {}});
+                return;
+            }
+            cur = it->second;
+        }
+    }
+
+    template <typename Fn>
+    void query(uint64_t hash, int radius, Fn&& visit) const {
+        if (nodes.empty()) return;
+        std::vector<int> stack{0};
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            int d = hamming(hash, node.hash);
+            if (d <= radius) {
+                for (int item : node.items) visit(item);
+            }
+            for (const auto& [edge, child] : node.children) {
+                if (edge >= d - radius && edge <= d + radius) stack.push_back(child);
+            }
+        }
+    }
+
+private:
+    struct Node {
+        uint64_t hash;
+        std::vector<int> items;
+        std::vector<std::pair<int, int>> children; // edge distance, node index
+    };
+    std::vector<Node> nodes;
+};
+
+int findRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+} // namespace
+
+DuplicateFinder::DuplicateFinder(int maxDistance) : maxDistance_(maxDistance) {}
+
+// dHash: shrink to 9x8 and record whether each pixel is brighter than its
+// right neighbour. Robust to scaling, re-encoding and small exposure shifts.
+uint64_t DuplicateFinder::dHash(const cv::Mat& gray) {
+    cv::Mat small;
+    cv::resize(gray, small, cv::Size(9, 8), 0, 0, cv::INTER_AREA);
+    uint64_t hash = 0;
+    for (int y = 0; y < 8; ++y) {
+        const uchar* row = small.ptr<uchar>(y);
+        for (int x = 0; x < 8; ++x) {
+            hash = (hash << 1) | (row[x] > row[x + 1] ? 1u : 0u);
+        }
+    }
+    return hash;
+}
+
+bool DuplicateFinder::hashFile(const fs::path& path, uint64_t& hash) {
+    // 1/8 scale decode: JPEG skips most of the IDCT work, and the hash only needs 9x8 pixels
+    cv::Mat gray = ImageLoader::load(path, cv::IMREAD_REDUCED_GRAYSCALE_8);
+    if (gray.empty()) return false;
+    hash = dHash(gray);
+    return true;
+}
+
+std::vector<DuplicateFinder::Group> DuplicateFinder::findGroups(const std::vector<fs::path>& files) {
+    struct Job {
+        fs::path path;
+        long long mtime;
+        uint64_t hash;
+        bool valid;
+        bool cached;
+    };
+
+    std::vector<Job> jobs;
+    jobs.reserve(files.size());
+    for (const auto& f : files) {
+        jobs.push_back({f, IndexCache::modifiedTime(f), 0, false, false});
+    }
+
+    // reuse cached hashes whose mtime still matches
+    std::map<fs::path, HashIndex> indexes;
+    for (auto& job : jobs) {
+        fs::path dir = job.path.parent_path();
+        auto it = indexes.find(dir);
+        if (it == indexes.end()) {
+            it = indexes.emplace(dir, readIndex(IndexCache::pathFor(dir, "dhash"))).first;
+        }
+        auto hit = it->second.find(job.path.filename().string());
+        // files that failed to decode are remembered too, so they are not retried every scan
+        if (hit != it->second.end() && hit->second.mtime == job.mtime) {
+            job.hash = hit->second.hash;
+            job.valid = hit->second.hashable != 0;
+            job.cached = true;
+        }
+    }
+
+    std::vector<Job*> pending;
+    for (auto& job : jobs) {
+        if (!job.cached) pending.push_back(&job);
+    }
+    QtConcurrent::blockingMap(IndexCache::pool(), pending, [](Job* job) {
+        job->valid = hashFile(job->path, job->hash);
+    });
+
+    // rewrite each index with exactly the files that still exist
+    if (!pending.empty()) {
+        for (auto& [dir, index] : indexes) index.clear();
+        for (const auto& job : jobs) {
+            if (job.mtime >= 0) {
+                indexes[job.path.parent_path()][job.path.filename().string()] =
+                    {job.mtime, job.valid ? job.hash : 0, static_cast<uint8_t>(job.valid)};
+            }
+        }
+        for (const auto& [dir, index] : indexes) {
+            writeIndex(IndexCache::pathFor(dir, "dhash"), index);
+        }
+    }
+
+    // build the tree, then union every pair found within range
+    BKTree tree;
+    std::vector<int> parent(jobs.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    for (int i = 0; i < static_cast<int>(jobs.size()); ++i) {
+        if (!jobs[i].valid) continue;
+        tree.query(jobs[i].hash, maxDistance_, [&](int j) {
+            int a = findRoot(parent, i), b = findRoot(parent, j);
+            if (a != b) parent[a] = b;
+        });
+        tree.insert(jobs[i].hash, i);
+    }
+
+    std::map<int, Group> byRoot;
+    for (int i = 0; i < static_cast<int>(jobs.size()); ++i) {
+        if (jobs[i].valid) byRoot[findRoot(parent, i)].push_back(jobs[i].path);
+    }
+
+    std::vector<Group> groups;
+    for (auto& [root, group] : byRoot) {
+        if (group.size() > 1) {
+            std::sort(group.begin(), group.end());
+            groups.push_back(std::move(group));
+        }
+    }
+    return groups;
+}
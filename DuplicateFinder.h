@@ -0,0 +1,32 @@
+#ifndef DUPLICATE_FINDER_H
+#define DUPLICATE_FINDER_H
+
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+// Finds near-duplicate images (burst frames, re-saves) using perceptual hashes
+class DuplicateFinder {
+public:
+    using Group = std::vector<std::filesystem::path>;
+
+    explicit DuplicateFinder(int maxDistance = 10);
+
+    // Hash every file in parallel and return groups of two or more images
+    // whose hashes are within maxDistance bits. Hashes are cached per
+    // directory keyed by mtime, so a rescan only decodes changed files.
+    std::vector<Group> findGroups(const std::vector<std::filesystem::path>& files);
+
+    // 64-bit difference hash of a grayscale image
+    static uint64_t dHash(const cv::Mat& gray);
+
+    // decode at reduced resolution and hash; false if the file can't be read
+    static bool hashFile(const std::filesystem::path& path, uint64_t& hash);
+
+private:
+    int maxDistance_;
+};
+
+#endif
+//duplicate finder
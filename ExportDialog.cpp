@@ -0,0 +1,120 @@
+#include "ExportDialog.h"
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QSettings>
+#include <QStandardPaths>
+#include <algorithm>
+
+ExportDialog::ExportDialog(const QString &baseName, QWidget *parent) : QDialog(parent)
+{
+    setWindowTitle("Export");
+    QSettings settings("MySoft", "ProImageViewer");
+
+    QFormLayout *form = new QFormLayout(this);
+
+    // formats
+    QWidget *formats = new QWidget();
+    QHBoxLayout *formatLayout = new QHBoxLayout(formats);
+    formatLayout->setContentsMargins(0, 0, 0, 0);
+    jpegBox = new QCheckBox("JPEG");
+    webpBox = new QCheckBox("WebP");
+    pngBox = new QCheckBox("PNG");
+    jpegBox->setChecked(settings.value("exportJpeg", true).toBool());
+    webpBox->setChecked(settings.value("exportWebp", false).toBool());
+    pngBox->setChecked(settings.value("exportPng", false).toBool());
+    formatLayout->addWidget(jpegBox);
+    formatLayout->addWidget(webpBox);
+    formatLayout->addWidget(pngBox);
+    form->addRow("Formats:", formats);
+
+    // sizes as a comma separated list of long-edge pixels
+    sizesEdit = new QLineEdit(settings.value("exportSizes", "full").toString());
+    sizesEdit->setToolTip("Long edge in pixels, comma separated. \"full\" keeps the original size.");
+    form->addRow("Sizes:", sizesEdit);
+
+    targetSpin = new QSpinBox();
+    targetSpin->setRange(0, 1000000);
+    targetSpin->setSuffix(" KB");
+    targetSpin->setSpecialValueText("No target");
+    targetSpin->setValue(settings.value("exportTargetKB", 0).toInt());
+    targetSpin->setToolTip("JPEG and WebP pick the highest quality that fits.");
+    form->addRow("Target size:", targetSpin);
+
+    // output location
+    QWidget *dirRow = new QWidget();
+    QHBoxLayout *dirLayout = new QHBoxLayout(dirRow);
+    dirLayout->setContentsMargins(0, 0, 0, 0);
+    QString defaultDir = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
+    dirEdit = new QLineEdit(settings.value("exportDir", defaultDir).toString());
+    QPushButton *browseBtn = new QPushButton("Browse...");
+    connect(browseBtn, &QPushButton::clicked, this, [this]() {
+        QString dir = QFileDialog::getExistingDirectory(this, "Export To", dirEdit->text());
+        if (!dir.isEmpty())
+            dirEdit->setText(dir);
+    });
+    dirLayout->addWidget(dirEdit);
+    dirLayout->addWidget(browseBtn);
+    form->addRow("Folder:", dirRow);
+
+    nameEdit = new QLineEdit(baseName);
+    form->addRow("Name:", nameEdit);
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, this, [this]() {
+        QSettings settings("MySoft", "ProImageViewer");
+        settings.setValue("exportJpeg", jpegBox->isChecked());
+        settings.setValue("exportWebp", webpBox->isChecked());
+        settings.setValue("exportPng", pngBox->isChecked());
+        settings.setValue("exportSizes", sizesEdit->text());
+        settings.setValue("exportTargetKB", targetSpin->value());
+        settings.setValue("exportDir", dirEdit->text());
+        accept();
+    });
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    form->addRow(buttons);
+}
+
+// every checked format at every listed size
+std::vector<Exporter::Variant> ExportDialog::variants() const
+{
+    std::vector<int> edges;
+    for (const QString &part : sizesEdit->text().split(',', Qt::SkipEmptyParts)) {
+        QString token = part.trimmed();
+        bool ok = false;
+        int edge = token.toInt(&ok);
+        if (token.compare("full", Qt::CaseInsensitive) == 0)
+            edge = 0;
+        else if (!ok || edge <= 0)
+            continue;
+        if (std::find(edges.begin(), edges.end(), edge) == edges.end())
+            edges.push_back(edge);
+    }
+    if (edges.empty())
+        edges.push_back(0);
+
+    std::vector<Exporter::Variant> out;
+    for (int edge : edges) {
+        if (jpegBox->isChecked()) out.push_back({"jpg", edge});
+        if (webpBox->isChecked()) out.push_back({"webp", edge});
+        if (pngBox->isChecked()) out.push_back({"png", edge});
+    }
+    return out;
+}
+
+size_t ExportDialog::targetBytes() const
+{
+    return static_cast<size_t>(targetSpin->value()) * 1024;
+}
+
+QString ExportDialog::outputDir() const
+{
+    return dirEdit->text();
+}
+
+QString ExportDialog::baseName() const
+{
+    return nameEdit->text().trimmed();
+}
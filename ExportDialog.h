@@ -0,0 +1,32 @@
+#ifndef EXPORT_DIALOG_H
+#define EXPORT_DIALOG_H
+
+#include <QDialog>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <vector>
+#include "Exporter.h"
+
+// Collects formats, sizes, a target file size and the output location
+class ExportDialog : public QDialog {
+public:
+    explicit ExportDialog(const QString& baseName, QWidget *parent = nullptr);
+
+    std::vector<Exporter::Variant> variants() const;
+    size_t targetBytes() const;
+    QString outputDir() const;
+    QString baseName() const;
+
+private:
+    QCheckBox* jpegBox;
+    QCheckBox* webpBox;
+    QCheckBox* pngBox;
+    QLineEdit* sizesEdit;
+    QSpinBox* targetSpin;
+    QLineEdit* dirEdit;
+    QLineEdit* nameEdit;
+};
+
+#endif
+//export dialog
@@ -0,0 +1,167 @@
+#include "Exporter.h"
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int kMaxRounds = 3;
+
+struct Candidate {
+    size_t variant;
+    int quality;
+    std::vector<uchar> bytes;
+    bool ok = false;
+};
+
+// per-variant state of the quality search
+struct Search {
+    int fits = 0;        // highest quality known to fit the target (0 = none yet)
+    int tooBig = 101;    // lowest quality known to exceed it
+    Exporter::Result best;
+    Exporter::Result fallback;   // smallest oversize encode, used if nothing fits
+};
+
+bool isLossy(const std::string& format) {
+    return format == "jpg" || format == "webp";
+}
+
+std::vector<int> encodeParams(const std::string& format, int quality) {
+    if (format == "jpg") return {cv::IMWRITE_JPEG_QUALITY, quality};
+    if (format == "webp") return {cv::IMWRITE_WEBP_QUALITY, std::max(quality, 1)};
+    return {cv::IMWRITE_PNG_COMPRESSION, 3};
+}
+
+// up to n qualities evenly spread strictly between lo and hi
+std::vector<int> qualitiesBetween(int lo, int hi, int n) {
+    std::vector<int> qs;
+    double step = (hi - lo) / (n + 1.0);
+    for (int i = 1; i <= n; ++i) {
+        int q = lo + static_cast<int>(std::lround(step * i));
+        if (q > lo && q < hi && (qs.empty() || qs.back() != q)) qs.push_back(q);
+    }
+    return qs;
+}
+
+cv::Mat scaledTo(const cv::Mat& src, int longEdge) {
+    int current = std::max(src.cols, src.rows);
+    if (longEdge <= 0 || longEdge >= current) return src;
+    double scale = static_cast<double>(longEdge) / current;
+    cv::Mat dst;
+    cv::resize(src, dst, cv::Size(), scale, scale, cv::INTER_AREA);
+    return dst;
+}
+
+} // namespace
+
+std::vector<Exporter::Result> Exporter::encode(const cv::Mat& src, const std::vector<Variant>& variants,
+                                               size_t targetBytes) {
+    if (src.empty() || variants.empty()) return {};
+
+    // one resized source per distinct size, resized in parallel
+    std::vector<std::pair<int, cv::Mat>> sizes;
+    for (const auto& v : variants) {
+        auto it = std::find_if(sizes.begin(), sizes.end(),
+                               [&v](const auto& s) { return s.first == v.longEdge; });
+        if (it == sizes.end()) sizes.emplace_back(v.longEdge, cv::Mat());
+    }
+    QtConcurrent::blockingMap(sizes, [&src](std::pair<int, cv::Mat>& s) {
+        s.second = scaledTo(src, s.first);
+    });
+    auto sourceFor = [&sizes](const Variant& v) -> const cv::Mat& {
+        return std::find_if(sizes.begin(), sizes.end(),
+                            [&v](const auto& s) { return s.first == v.longEdge; })->second;
+    };
+
+    std::vector<Search> searches(variants.size());
+    auto searching = [&](size_t i) { return isLossy(variants[i].format) && targetBytes > 0; };
+
+    // every round encodes all candidates of all variants at once
+    auto runRound = [&](std::vector<Candidate>& round) {
+        QtConcurrent::blockingMap(round, [&](Candidate& c) {
+            const Variant& v = variants[c.variant];
+            c.ok = cv::imencode("." + v.format, sourceFor(v), c.bytes, encodeParams(v.format, c.quality));
+        });
+
+        for (auto& c : round) {
+            if (!c.ok) continue;
+            Search& s = searches[c.variant];
+            Result r{variants[c.variant], std::move(c.bytes), isLossy(variants[c.variant].format) ? c.quality : -1, true};
+
+            if (!searching(c.variant)) {
+                r.metTarget = targetBytes == 0 || r.bytes.size() <= targetBytes;
+                s.best = std::move(r);
+            } else if (r.bytes.size() <= targetBytes) {
+                if (c.quality > s.fits) {
+                    s.fits = c.quality;
+                    s.best = std::move(r);
+                }
+            } else {
+                s.tooBig = std::min(s.tooBig, c.quality);
+                if (s.fallback.bytes.empty() || r.bytes.size() < s.fallback.bytes.size()) {
+                    r.metTarget = false;
+                    s.fallback = std::move(r);
+                }
+            }
+        }
+    };
+
+    std::vector<Candidate> round;
+    for (size_t i = 0; i < variants.size(); ++i) {
+        if (!searching(i)) {
+            round.push_back({i, kDefaultQuality, {}});
+            continue;
+        }
+        // first round is weighted towards the qualities people actually use
+        for (int q : {40, 60, 75, 85, 95}) round.push_back({i, q, {}});
+    }
+    runRound(round);
+
+    // narrow each bracket (fits, tooBig) until it is one step wide
+    for (int r = 1; r < kMaxRounds; ++r) {
+        round.clear();
+        for (size_t i = 0; i < variants.size(); ++i) {
+            if (!searching(i) || searches[i].tooBig - searches[i].fits <= 1) continue;
+            for (int q : qualitiesBetween(searches[i].fits, searches[i].tooBig, 5)) round.push_back({i, q, {}});
+        }
+        if (round.empty()) break;
+        runRound(round);
+    }
+
+    std::vector<Result> results;
+    for (auto& s : searches) {
+        if (!s.best.bytes.empty()) results.push_back(std::move(s.best));
+        else if (!s.fallback.bytes.empty()) results.push_back(std::move(s.fallback));
+    }
+    return results;
+}
+
+fs::path Exporter::fileName(const std::string& base, const Variant& variant, bool sizeSuffix) {
+    std::string name = base;
+    if (sizeSuffix) name += "_" + (variant.longEdge ? std::to_string(variant.longEdge) : std::string("full"));
+    return name + "." + variant.format;
+}
+
+bool Exporter::write(const fs::path& path, const Result& result) {
+    fs::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(result.bytes.data()),
+                  static_cast<std::streamsize>(result.bytes.size()));
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) fs::remove(tmp, ec);
+    return !ec;
+}
@@ -0,0 +1,41 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Encodes one image into several formats and sizes at once. With a byte
+// target, lossy formats get a quality search whose candidate encodes run
+// in parallel in memory; only the winning encode of each variant is kept.
+class Exporter {
+public:
+    struct Variant {
+        std::string format;   // "jpg", "webp" or "png"
+        int longEdge = 0;     // 0 keeps the original size
+    };
+
+    struct Result {
+        Variant variant;
+        std::vector<uchar> bytes;
+        int quality = -1;     // -1 for lossless formats
+        bool metTarget = true;
+    };
+
+    // targetBytes == 0 encodes lossy formats at a fixed quality instead
+    static std::vector<Result> encode(const cv::Mat& src, const std::vector<Variant>& variants,
+                                      size_t targetBytes);
+
+    // <base>[_<edge>|_full].<format>; the size suffix only when several sizes are exported
+    static std::filesystem::path fileName(const std::string& base, const Variant& variant, bool sizeSuffix);
+
+    // Write the encoded bytes as-is through a temp file renamed into place,
+    // so a failed write never leaves a truncated image; false on I/O failure
+    static bool write(const std::filesystem::path& path, const Result& result);
+
+    static constexpr int kDefaultQuality = 90;
+};
+
+#endif
+//exporter
@@ -0,0 +1,274 @@
+#include "FramePlayer.h"
+#include "ImageUtils.h"
+#include "MemoryAccountant.h"
+#include <QImageReader>
+#include <QtConcurrent>
+#include <algorithm>
+#include <mutex>
+
+namespace fs = std::filesystem;
+
+// Random or sequential access to the frames of one file
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+    virtual int count() const = 0;
+    virtual bool animated() const = 0;
+    virtual bool read(int index, cv::Mat& image, int& delayMs) = 0;
+};
+
+namespace {
+
+// Multi-page TIFF: each page is decoded independently with imreadmulti
+class PageSource : public FrameSource {
+public:
+    PageSource(const fs::path& path, int pages) : path_(path.string()), pages_(pages) {}
+
+    int count() const override { return pages_; }
+    bool animated() const override { return false; }
+
+    bool read(int index, cv::Mat& image, int& delayMs) override {
+        std::vector<cv::Mat> pages;
+        if (!cv::imreadmulti(path_, pages, index, 1, cv::IMREAD_COLOR) || pages.empty())
+            return false;
+        image = pages.front();
+        delayMs = 0;
+        return true;
+    }
+
+private:
+    std::string path_;
+    int pages_;
+};
+
+// Animated GIF/WebP through Qt's animation-aware reader. Frames may be
+// deltas of earlier ones, so the reader only moves forward; going back
+// reopens the file.
+class AnimationSource : public FrameSource {
+public:
+    AnimationSource(const fs::path& path, int frames)
+        : path_(QString::fromStdString(path.string())), frames_(frames), next_(0) {}
+
+    int count() const override { return frames_; }
+    bool animated() const override { return true; }
+
+    bool read(int index, cv::Mat& image, int& delayMs) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!reader_ || index < next_) {
+            reader_ = std::make_unique<QImageReader>(path_);
+            next_ = 0;
+        }
+
+        QImage frame;
+        while (next_ <= index) {
+            frame = reader_->read();
+            if (frame.isNull()) return false;
+            delayMs = reader_->nextImageDelay();
+            ++next_;
+        }
+        // same rule browsers use for zero or near-zero delays
+        if (delayMs <= 10) delayMs = 100;
+        image = ImageUtils::qImageToMat(frame);
+        return !image.empty();
+    }
+
+private:
+    QString path_;
+    int frames_;
+    int next_;
+    std::unique_ptr<QImageReader> reader_;
+    std::mutex mutex_;
+};
+
+std::shared_ptr<FrameSource> probe(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    if (ext == ".tif" || ext == ".tiff") {
+        // imcount walks the IFD chain without decoding any page
+        int pages = static_cast<int>(cv::imcount(path.string()));
+        if (pages > 1) return std::make_shared<PageSource>(path, pages);
+    } else if (ext == ".gif" || ext == ".webp") {
+        QImageReader reader(QString::fromStdString(path.string()));
+        int frames = reader.imageCount();
+        if (reader.supportsAnimation() && frames > 1)
+            return std::make_shared<AnimationSource>(path, frames);
+    }
+    return nullptr;
+}
+
+} // namespace
+
+FramePlayer::FramePlayer(QObject* parent)
+    : QObject(parent), ringLimit(kRingSize), currentIndex_(0), frameCount_(0), nextToDecode(0),
+      decodingIndex(-1), wantedIndex(-1), generation(0), playing(false)
+{
+    watcher = new QFutureWatcher<Frame>(this);
+    connect(watcher, &QFutureWatcher<Frame>::finished, this, &FramePlayer::onDecoded);
+
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, [this]() { step(1); });
+
+    // decoded-ahead frames are a cache: cheap to drop, decoded again on demand
+    memorySource = MemoryAccountant::instance().add(
+        MemoryAccountant::Owner::Cache, 10,
+        [this](std::vector<MemoryAccountant::Buffer>& out) {
+            for (const Frame& f : ring)
+                out.push_back(MemoryAccountant::buffer("decoded frame " + std::to_string(f.index), f.image));
+        },
+        [this](size_t) {
+            if (ring.empty()) return size_t(0);
+            size_t freed = 0;
+            for (const Frame& f : ring) freed += f.image.total() * f.image.elemSize();
+            // resume decoding at the first dropped frame, one frame ahead at most
+            int resume = ring.front().index;
+            ++generation;
+            ring.clear();
+            decodingIndex = -1;
+            nextToDecode = resume;
+            ringLimit = 1;
+            requestDecode();
+            return freed;
+        });
+}
+
+FramePlayer::~FramePlayer() {
+    MemoryAccountant::instance().remove(memorySource);
+    close();
+    watcher->waitForFinished();
+}
+
+bool FramePlayer::isAnimated() const {
+    return source && source->animated();
+}
+
+bool FramePlayer::open(const fs::path& path, cv::Mat& first) {
+    close();
+    std::shared_ptr<FrameSource> probed = probe(path);
+    if (!probed) return false;
+
+    Frame frame;
+    if (!probed->read(0, frame.image, frame.delayMs)) return false;
+
+    source = probed;
+    ringLimit = kRingSize;
+    frameCount_ = source->count();
+    nextToDecode = 1 % frameCount_;
+    current_ = frame.image;
+    currentIndex_ = 0;
+    first = frame.image;
+
+    // the caller displays the first frame itself, so no frameChanged here
+    playing = source->animated();
+    if (playing) timer->start(std::max(frame.delayMs, 1));
+    requestDecode();
+    return true;
+}
+
+// In-flight decodes keep their own reference to the source and are
+// discarded by generation when they finish, so closing never blocks.
+void FramePlayer::close() {
+    ++generation;
+    timer->stop();
+    ring.clear();
+    decodingIndex = -1;
+    source.reset();
+    current_ = cv::Mat();
+    currentIndex_ = 0;
+    frameCount_ = 0;
+    wantedIndex = -1;
+    playing = false;
+}
+
+void FramePlayer::play() {
+    if (!isAnimated() || playing) return;
+    playing = true;
+    step(1);
+}
+
+void FramePlayer::pause() {
+    playing = false;
+    timer->stop();
+}
+
+void FramePlayer::togglePlay() {
+    if (playing) pause();
+    else play();
+}
+
+void FramePlayer::step(int delta) {
+    if (!source) return;
+    timer->stop();
+    int target = ((currentIndex_ + delta) % frameCount_ + frameCount_) % frameCount_;
+
+    if (!ring.empty() && ring.front().index == target) {
+        Frame frame = std::move(ring.front());
+        ring.pop_front();
+        show(frame);
+        requestDecode();
+        return;
+    }
+    // not decoded yet: either the ring is starved or this is a jump
+    if (watcher->isRunning() && decodingIndex == target) {
+        wantedIndex = target;
+        return;
+    }
+    restartFrom(target);
+}
+
+void FramePlayer::restartFrom(int index) {
+    ++generation;
+    ring.clear();
+    decodingIndex = -1;
+    nextToDecode = index;
+    wantedIndex = index;
+    requestDecode();
+}
+
+void FramePlayer::requestDecode() {
+    if (!source || watcher->isRunning() || ring.size() >= ringLimit) return;
+
+    int index = nextToDecode;
+    int gen = generation;
+    std::shared_ptr<FrameSource> src = source;
+    decodingIndex = index;
+    nextToDecode = (nextToDecode + 1) % frameCount_;
+
+    watcher->setFuture(QtConcurrent::run([src, index, gen]() {
+        Frame frame;
+        frame.index = index;
+        frame.generation = gen;
+        if (!src->read(index, frame.image, frame.delayMs)) frame.image = cv::Mat();
+        return frame;
+    }));
+}
+
+void FramePlayer::onDecoded() {
+    Frame frame = watcher->result();
+    decodingIndex = -1;
+    if (frame.generation != generation) {
+        // stale decode from a closed file or an abandoned position
+        requestDecode();
+        return;
+    }
+
+    if (frame.image.empty()) {
+        // unreadable frame: skip it rather than stalling playback
+        if (wantedIndex == frame.index) wantedIndex = nextToDecode;
+    } else if (wantedIndex == frame.index) {
+        wantedIndex = -1;
+        show(frame);
+    } else {
+        ring.push_back(std::move(frame));
+    }
+    requestDecode();
+}
+
+void FramePlayer::show(const Frame& frame) {
+    current_ = frame.image;
+    currentIndex_ = frame.index;
+    emit frameChanged();
+    if (playing) timer->start(std::max(frame.delayMs, 1));
+}
@@ -0,0 +1,82 @@
+#ifndef FRAME_PLAYER_H
+#define FRAME_PLAYER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <opencv2/opencv.hpp>
+
+class FrameSource;
+
+// Streams pages of multi-page TIFFs and frames of animated GIF/WebP.
+// Frames are decoded on demand in the background into a small ring, so
+// memory stays constant no matter how many pages or frames the file has.
+class FramePlayer : public QObject {
+    Q_OBJECT
+
+public:
+    struct Frame {
+        cv::Mat image;
+        int index = 0;
+        int delayMs = 0;      // display time for animations, 0 for pages
+        int generation = 0;   // discards decodes that finish after close()
+    };
+
+    explicit FramePlayer(QObject* parent = nullptr);
+    ~FramePlayer();
+
+    // Returns false for ordinary single-frame files. Otherwise decodes the
+    // first frame into `first`, starts filling the ring and, for
+    // animations, starts playback.
+    bool open(const std::filesystem::path& path, cv::Mat& first);
+    void close();
+
+    bool isActive() const { return source != nullptr; }
+    bool isAnimated() const;
+    bool isPlaying() const { return playing; }
+    int currentIndex() const { return currentIndex_; }
+    int frameCount() const { return frameCount_; }
+    const cv::Mat& current() const { return current_; }
+
+    void play();
+    void pause();
+    void togglePlay();
+    // next/previous page or frame, wrapping around
+    void step(int delta);
+
+signals:
+    // current() holds a new frame
+    void frameChanged();
+
+private slots:
+    void onDecoded();
+
+private:
+    void requestDecode();
+    void show(const Frame& frame);
+    void restartFrom(int index);
+
+    static constexpr size_t kRingSize = 3;
+
+    std::shared_ptr<FrameSource> source;
+    QFutureWatcher<Frame>* watcher;
+    QTimer* timer;
+    std::deque<Frame> ring;   // decoded frames following the current one, in order
+    size_t ringLimit;         // kRingSize, or 1 after the memory budget shrank the ring
+    int memorySource;
+
+    cv::Mat current_;
+    int currentIndex_;
+    int frameCount_;
+    int nextToDecode;
+    int decodingIndex;        // frame the running decode belongs to, -1 if none
+    int wantedIndex;          // frame to show as soon as it is decoded, -1 if none
+    int generation;
+    bool playing;
+};
+
+#endif
+//frame player
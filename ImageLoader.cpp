@@ -0,0 +1,165 @@
+#include "ImageLoader.h"
+#include "ImageUtils.h"
+#include <QImageReader>
+#include <algorithm>
+#include <climits>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <sys/param.h>
+#include <sys/mount.h>
+#else
+#include <sys/vfs.h>
+#endif
+#define IMAGE_LOADER_MMAP 1
+#endif
+
+namespace fs = std::filesystem;
+
+#ifdef IMAGE_LOADER_MMAP
+namespace {
+
+// A mapped file that shrinks or vanishes under us raises SIGBUS on access.
+// Network mounts can do that at any time (truncation on the server, a
+// dropped connection), so only local filesystems are mapped.
+bool isLocalFilesystem(int fd) {
+    struct statfs info;
+    if (::fstatfs(fd, &info) != 0) return false;
+#if defined(__APPLE__)
+    return (info.f_flags & MNT_LOCAL) != 0;
+#else
+    switch (static_cast<unsigned long>(info.f_type)) {
+    case 0x6969:         // NFS
+    case 0x517B:         // SMB
+    case 0xFF534D42:     // CIFS
+    case 0xFE534D42:     // SMB2
+    case 0x65735546:     // FUSE (sshfs, rclone, ...)
+    case 0x00C36400:     // Ceph
+    case 0x5346414F:     // AFS
+    case 0x73757245:     // Coda
+    case 0x01021997:     // 9P
+        return false;
+    default:
+        return true;
+    }
+#endif
+}
+
+// read-only mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const fs::path& path) : data_(nullptr), size_(0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat st;
+        if (isLocalFilesystem(fd) && ::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = p;
+                size_ = static_cast<size_t>(st.st_size);
+                // the decoder walks the file front to back exactly once
+                ::madvise(data_, size_, MADV_SEQUENTIAL);
+                ::madvise(data_, size_, MADV_WILLNEED);
+            }
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) ::munmap(data_, size_);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return data_ != nullptr; }
+    size_t size() const { return size_; }
+
+    // header-only Mat over the mapped bytes; no copy
+    cv::Mat bytes() const { return cv::Mat(1, static_cast<int>(size_), CV_8UC1, data_); }
+
+private:
+    void* data_;
+    size_t size_;
+};
+
+} // namespace
+#endif
+
+namespace {
+
+// OpenCV only decodes GIF from 4.11 and only when built with it, so formats
+// it cannot read go through Qt. Reduced and grayscale flags are honoured.
+cv::Mat loadWithQt(const fs::path& path, int flags) {
+    QImageReader reader(QString::fromStdString(path.string()));
+    int scale = 1;
+    // the reduced flags are the grayscale bit patterns plus IMREAD_COLOR
+    if (flags > 0 && (flags & cv::IMREAD_REDUCED_GRAYSCALE_8)) scale = 8;
+    else if (flags > 0 && (flags & cv::IMREAD_REDUCED_GRAYSCALE_4)) scale = 4;
+    else if (flags > 0 && (flags & cv::IMREAD_REDUCED_GRAYSCALE_2)) scale = 2;
+    QSize size = reader.size();
+    if (scale > 1 && size.isValid()) reader.setScaledSize(size / scale);
+
+    cv::Mat mat = ImageUtils::qImageToMat(reader.read());
+    if (!mat.empty() && flags >= 0 && !(flags & cv::IMREAD_COLOR)) cv::cvtColor(mat, mat, cv::COLOR_BGR2GRAY);
+    return mat;
+}
+
+} // namespace
+
+cv::Mat ImageLoader::load(const fs::path& path, int flags) {
+#ifdef IMAGE_LOADER_MMAP
+    MappedFile file(path);
+    // network files and very large ones (cv::Mat columns are int) go through
+    // imread, whose buffered reads fail cleanly instead of faulting
+    if (file.isOpen() && file.size() < static_cast<size_t>(INT_MAX)) {
+        cv::Mat decoded = cv::imdecode(file.bytes(), flags);
+        if (!decoded.empty()) return decoded;
+    }
+#endif
+    cv::Mat decoded = cv::imread(path.string(), flags);
+    if (decoded.empty()) decoded = loadWithQt(path, flags);
+    return decoded;
+}
+
+int ImageLoader::previewScale(const fs::path& path, cv::Size image, cv::Size target) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext != ".jpg" && ext != ".jpeg") return 1;
+    if (image.width <= 0 || image.height <= 0 || target.width <= 0 || target.height <= 0) return 1;
+
+    int scale = 1;
+    while (scale < 8 && image.width / (scale * 2) >= target.width &&
+           image.height / (scale * 2) >= target.height)
+        scale *= 2;
+    return scale;
+}
+
+cv::Mat ImageLoader::loadReduced(const fs::path& path, int scale) {
+    switch (scale) {
+    case 2: return load(path, cv::IMREAD_REDUCED_COLOR_2);
+    case 4: return load(path, cv::IMREAD_REDUCED_COLOR_4);
+    case 8: return load(path, cv::IMREAD_REDUCED_COLOR_8);
+    default: return load(path);
+    }
+}
+
+void ImageLoader::prefetch(const fs::path& path) {
+#if defined(IMAGE_LOADER_MMAP) && defined(POSIX_FADV_WILLNEED)
+    if (path.empty()) return;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    // queues readahead of the whole file and returns without waiting
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    ::close(fd);
+#else
+    (void)path;
+#endif
+}
@@ -0,0 +1,30 @@
+#ifndef IMAGE_LOADER_H
+#define IMAGE_LOADER_H
+
+#include <filesystem>
+#include <opencv2/opencv.hpp>
+
+// Reads image files through a memory map and hints the kernel about files
+// we are likely to open next
+class ImageLoader {
+public:
+    // mmap the file and decode straight from the mapped pages, skipping the
+    // buffered read into a user-space copy. Network mounts and failures go
+    // through cv::imread, then Qt for formats OpenCV lacks.
+    static cv::Mat load(const std::filesystem::path& path, int flags = cv::IMREAD_COLOR);
+
+    // Largest power-of-two downscale (1, 2, 4 or 8) that still covers
+    // `target`. Only JPEG gets more than 1: its decoder scales inside the
+    // IDCT, while other formats decode at full size and resize afterwards.
+    static int previewScale(const std::filesystem::path& path, cv::Size image, cv::Size target);
+
+    // decode at 1/scale of the full resolution
+    static cv::Mat loadReduced(const std::filesystem::path& path, int scale);
+
+    // Ask the kernel to start reading the file into the page cache. Returns
+    // immediately, so it is cheap to call for several upcoming files.
+    static void prefetch(const std::filesystem::path& path);
+};
+
+#endif
+//image loader
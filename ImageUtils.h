@@ -3,6 +3,10 @@
 
 #include <QImage>
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mutex>
 #include <vector>
 
 class ImageUtils {
@@ -23,6 +27,17 @@ public:
         return QImage();
     }
 
+    // Convert a Qt QImage to a BGR Mat that owns its pixels
+    static cv::Mat qImageToMat(const QImage& src) {
+        if (src.isNull()) return cv::Mat();
+        QImage rgb = src.convertToFormat(QImage::Format_RGB888);
+        cv::Mat view(rgb.height(), rgb.width(), CV_8UC3,
+                     const_cast<uchar*>(rgb.constBits()), static_cast<size_t>(rgb.bytesPerLine()));
+        cv::Mat dst;
+        cv::cvtColor(view, dst, cv::COLOR_RGB2BGR);
+        return dst;
+    }
+
     // Transforms
     static cv::Mat adjustBrightnessContrast(const cv::Mat& src, double alpha, int beta) {
         cv::Mat dst;
@@ -78,6 +93,89 @@ public:
         rect = rect & cv::Rect(0, 0, src.cols, src.rows);
         return src(rect).clone();
     }
+
+    // Scale down to fit within maxWidth x maxHeight. Returns src itself
+    // (no copy) when it already fits.
+    static cv::Mat fitWithin(const cv::Mat& src, int maxWidth, int maxHeight) {
+        if (src.empty() || maxWidth <= 0 || maxHeight <= 0) return src;
+        double scale = std::min(static_cast<double>(maxWidth) / src.cols,
+                                static_cast<double>(maxHeight) / src.rows);
+        if (scale >= 1.0) return src;
+        cv::Mat dst;
+        cv::resize(src, dst, cv::Size(), scale, scale, cv::INTER_AREA);
+        return dst;
+    }
+
+    // Slider values (brightness, contrast x10, saturation) for auto-enhance
+    struct AutoLevels {
+        int brightness = 0;
+        int contrast = 10;
+        int saturation = 0;
+    };
+
+    // Estimate auto-levels from a strided subsample of about 256k pixels,
+    // so the cost is the same for a 1 MP and a 100 MP image. Stripes of
+    // sampled rows are histogrammed in parallel and merged.
+    static AutoLevels estimateAutoLevels(const cv::Mat& src) {
+        AutoLevels levels;
+        if (src.empty() || src.depth() != CV_8U) return levels;
+
+        const int channels = src.channels();
+        const int step = std::max(1, static_cast<int>(std::sqrt(src.total() / 262144.0)));
+        const int sampledRows = (src.rows + step - 1) / step;
+
+        std::array<long long, 256> hist{};
+        double satSum = 0.0;
+        long long samples = 0;
+        std::mutex merge;
+
+        cv::parallel_for_(cv::Range(0, sampledRows), [&](const cv::Range& range) {
+            std::array<long long, 256> localHist{};
+            double localSat = 0.0;
+            long long localSamples = 0;
+            for (int r = range.start; r < range.end; ++r) {
+                const uchar* row = src.ptr<uchar>(r * step);
+                for (int x = 0; x < src.cols; x += step) {
+                    const uchar* px = row + x * channels;
+                    uchar lo = px[0], hi = px[0];
+                    for (int c = 0; c < channels; ++c) {
+                        localHist[px[c]]++;
+                        lo = std::min(lo, px[c]);
+                        hi = std::max(hi, px[c]);
+                    }
+                    // HSV saturation, 0-255
+                    if (hi > 0) localSat += 255.0 * (hi - lo) / hi;
+                    localSamples++;
+                }
+            }
+            std::lock_guard<std::mutex> lock(merge);
+            for (int i = 0; i < 256; ++i) hist[i] += localHist[i];
+            satSum += localSat;
+            samples += localSamples;
+        });
+        if (samples == 0) return levels;
+
+        // 0.5% / 99.5% clip points over all channel values
+        const long long total = samples * channels;
+        const long long clip = total / 200;
+        int low = 0, high = 255;
+        for (long long acc = 0; low < 255 && (acc += hist[low]) <= clip; ++low) {}
+        for (long long acc = 0; high > 0 && (acc += hist[high]) <= clip; --high) {}
+        if (high - low < 16) return levels; // flat image, leave it alone
+
+        // stretch [low, high] to [0, 255], quantised to the slider steps
+        levels.contrast = std::clamp(static_cast<int>(std::lround(2550.0 / (high - low))), 10, 30);
+        double alpha = levels.contrast / 10.0;
+        levels.brightness = std::clamp(static_cast<int>(std::lround(-low * alpha)), -100, 100);
+
+        // lift dull colour images towards a moderate mean saturation;
+        // near-grey images stay grey
+        const double meanSat = satSum / samples;
+        const double targetSat = 90.0;
+        if (channels == 3 && meanSat > 12.0 && meanSat < targetSat)
+            levels.saturation = std::min(40, static_cast<int>(std::lround(targetSat - meanSat)));
+        return levels;
+    }
 };
 
 #endif //image utilis
\ No newline at end of file
@@ -0,0 +1,114 @@
+#ifndef INDEX_CACHE_H
+#define INDEX_CACHE_H
+
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QString>
+#include <QCoreApplication>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+class IndexCache {
+public:
+    // Location of a per-directory cache file. We key it by a hash of the
+    // directory path and keep it in the user cache dir so photo folders
+    // (which may be read-only or shared) are never written to.
+    static std::filesystem::path pathFor(const std::filesystem::path& dir, const std::string& name) {
+        QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        if (base.isEmpty()) return {};
+
+        std::filesystem::path root(base.toStdString());
+        std::error_code ec;
+        std::filesystem::create_directories(root, ec);
+        if (ec) return {};
+
+        QByteArray key = QCryptographicHash::hash(
+            QByteArray::fromStdString(std::filesystem::absolute(dir).lexically_normal().string()),
+            QCryptographicHash::Sha1).toHex();
+        return root / (key.toStdString() + "." + name);
+    }
+
+    // Pool for the batch indexers. A first index of a big folder can take
+    // minutes; on the global pool it would queue frame decodes, prefetch,
+    // undo packing and export behind it. Half the cores is plenty for I/O.
+    static QThreadPool* pool() {
+        static QThreadPool* indexers = [] {
+            // owned by the application so it is joined on exit like the global pool
+            auto* p = new QThreadPool(QCoreApplication::instance());
+            p->setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+            return p;
+        }();
+        return indexers;
+    }
+
+    // mtime as a plain integer so it can be stored and compared across runs
+    static long long modifiedTime(const std::filesystem::path& path) {
+        std::error_code ec;
+        auto t = std::filesystem::last_write_time(path, ec);
+        if (ec) return -1;
+        return static_cast<long long>(t.time_since_epoch().count());
+    }
+
+    // Reads and checks the magic, version, count header shared by all index
+    // files. minEntryBytes is the smallest an entry can be on disk; a count
+    // the rest of the file could not hold means a corrupt header.
+    static bool readHeader(std::ifstream& in, uint32_t magic, uint32_t version,
+                           size_t minEntryBytes, uint32_t& count) {
+        uint32_t fileMagic = 0, fileVersion = 0;
+        in.read(reinterpret_cast<char*>(&fileMagic), sizeof(fileMagic));
+        in.read(reinterpret_cast<char*>(&fileVersion), sizeof(fileVersion));
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (!in || fileMagic != magic || fileVersion != version) return false;
+        return fits(in, count, minEntryBytes);
+    }
+
+    // true if count records of at least bytesEach can still follow in the file
+    static bool fits(std::ifstream& in, uint64_t count, size_t bytesEach) {
+        std::streampos pos = in.tellg();
+        in.seekg(0, std::ios::end);
+        std::streampos end = in.tellg();
+        in.seekg(pos);
+        if (!in || pos < 0 || end < pos) return false;
+        return count * bytesEach <= static_cast<uint64_t>(end - pos);
+    }
+
+    // Writes the header, then lets body write the entries. Everything goes to
+    // a temp file that is renamed over the old one, so a crash never leaves a
+    // half-written index behind. The temp name is unique per writer because two
+    // builds of the same folder can overlap.
+    template <typename Body>
+    static bool write(const std::filesystem::path& file, uint32_t magic, uint32_t version,
+                      uint32_t count, Body&& body) {
+        if (file.empty()) return false;
+        static std::atomic<unsigned> serial{0};
+        std::filesystem::path tmp = file;
+        tmp += "." + std::to_string(QCoreApplication::applicationPid()) + "-" +
+               std::to_string(serial++) + ".tmp";
+
+        bool ok;
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) return false;
+            out.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+            out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            body(out);
+            ok = static_cast<bool>(out);
+        }
+        std::error_code ec;
+        if (ok) {
+            std::filesystem::rename(tmp, file, ec);
+            ok = !ec;
+        }
+        if (!ok) std::filesystem::remove(tmp, ec);
+        return ok;
+    }
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "MainWindow.h"
 #include "ImageUtils.h"
+#include "ImageLoader.h"
 #include <QMenuBar>
 #include <QStatusBar>
 #include <QFileDialog>
@@ -12,10 +13,24 @@
 #include <QToolBar>
 #include <QStyle>
 #include <QMouseEvent>
+#include <QInputDialog>
+#include <QtConcurrent>
+#include <QTimer>
+#include <QGraphicsPixmapItem>
+#include <QDebug>
+#include <algorithm>
+#include <cstdlib>
+#include "StartupProfiler.h"
+#include "CompareView.h"
+#include "MemoryAccountant.h"
+#include "ExportDialog.h"
+#include "IndexCache.h"
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), undoIndex(-1), fitToWindow(true),
-      currentScale(1.0), isGrayscale(false), cropMode(false)
+    : QMainWindow(parent), brightnessSlider(nullptr), contrastSlider(nullptr),
+      saturationSlider(nullptr), blurSlider(nullptr), duplicateMode(false), undoIndex(-1),
+      fitToWindow(true), currentScale(1.0), isGrayscale(false), cropMode(false),
+      autoEnhanceOnLoad(false), compareView(nullptr), scenePixmapBytes(0), firstPaintSeen(false), editorScheduled(false), startupLoading(false)
 {
     // Create the main graphics view for image display
     scene = new QGraphicsScene(this);
@@ -26,7 +41,13 @@ MainWindow::MainWindow(QWidget *parent)
     view->viewport()->installEventFilter(this);
     setCentralWidget(view);
 
-    setupEditorPanel();
+    // only the dock frame is created here so restoreState() can place it;
+    // its contents are built after the first paint (ensureEditorPanel)
+    editorDock = new QDockWidget("Editor", this);
+    editorDock->setObjectName("editorDock");
+    editorDock->setAllowedAreas(Qt::RightDockWidgetArea | Qt::LeftDockWidgetArea);
+    addDockWidget(Qt::RightDockWidgetArea, editorDock);
+
     setupToolbar();
     createMenuBar();
 
@@ -35,10 +56,30 @@ MainWindow::MainWindow(QWidget *parent)
     statusLabel = new QLabel("Ready");
     statusBar()->addWidget(statusLabel);
 
+    framePlayer = new FramePlayer(this);
+    connect(framePlayer, &FramePlayer::frameChanged, this, &MainWindow::showFrame);
+
+    duplicateWatcher = new QFutureWatcher<std::vector<DuplicateFinder::Group>>(this);
+    connect(duplicateWatcher, &QFutureWatcher<std::vector<DuplicateFinder::Group>>::finished,
+            this, &MainWindow::onDuplicatesFound);
+
+    metadataWatcher = new QFutureWatcher<std::vector<ImageMetadata>>(this);
+    connect(metadataWatcher, &QFutureWatcher<std::vector<ImageMetadata>>::finished,
+            this, &MainWindow::onMetadataReady);
+
+    exportWatcher = new QFutureWatcher<QStringList>(this);
+    connect(exportWatcher, &QFutureWatcher<QStringList>::finished, this, &MainWindow::onExportFinished);
+
+    registerMemorySources();
+
     loadSettings();
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow()
+{
+    for (int id : memorySources)
+        MemoryAccountant::instance().remove(id);
+}
 
 void MainWindow::createMenuBar()
 {
@@ -52,6 +93,7 @@ void MainWindow::createMenuBar()
                         this, &MainWindow::saveFile, QKeySequence::Save);
     fileMenu->addAction(QIcon::fromTheme("document-save-as"), "Save &As...",
                         this, &MainWindow::saveAsFile, QKeySequence::SaveAs);
+    fileMenu->addAction("&Export...", this, &MainWindow::exportImage, Qt::CTRL | Qt::SHIFT | Qt::Key_E);
     fileMenu->addSeparator();
 
     fileMenu->addAction("E&xit", qApp, &QApplication::quit, QKeySequence::Quit);
@@ -68,6 +110,14 @@ void MainWindow::createMenuBar()
 
     editMenu->addAction("Crop Mode", this, &MainWindow::toggleCropMode, Qt::Key_C);
 
+    editMenu->addSeparator();
+
+    editMenu->addAction("Auto &Enhance", this, &MainWindow::autoEnhance, Qt::Key_E);
+
+    autoEnhanceAction = editMenu->addAction("Auto Enhance on &Load");
+    autoEnhanceAction->setCheckable(true);
+    connect(autoEnhanceAction, &QAction::toggled, this, [this](bool on) { autoEnhanceOnLoad = on; });
+
     // View menu
     QMenu *viewMenu = menuBar()->addMenu("&View");
 
@@ -75,18 +125,69 @@ void MainWindow::createMenuBar()
 
     viewMenu->addAction("Zoom &Out", this, &MainWindow::zoomOut, QKeySequence::ZoomOut);
 
+    viewMenu->addAction("&Compare Before/After", this, &MainWindow::toggleCompare, Qt::Key_B);
+
     QAction *fitAction = viewMenu->addAction("&Fit to Window",
                                               this, &MainWindow::toggleFitToWindow, Qt::Key_F);
 
     fitAction->setCheckable(true);
     fitAction->setChecked(fitToWindow);
 
+    viewMenu->addSeparator();
+
+    viewMenu->addAction("Memory &Budget...", this, &MainWindow::setMemoryBudget);
+    viewMenu->addAction("Memory &Report...", this, &MainWindow::showMemoryReport);
+
+    viewMenu->addSeparator();
+
+    // sort and filter run against the metadata index, never the files
+    QMenu *sortMenu = viewMenu->addMenu("&Sort By");
+    sortGroup = new QActionGroup(this);
+    const std::pair<const char *, DirectoryScanner::SortOrder> sortOrders[] = {
+        {"&Name", DirectoryScanner::SortOrder::Name},
+        {"&Date Taken", DirectoryScanner::SortOrder::DateTaken},
+        {"D&imensions", DirectoryScanner::SortOrder::Dimensions},
+        {"File &Size", DirectoryScanner::SortOrder::FileSize},
+        {"&Camera", DirectoryScanner::SortOrder::Camera},
+    };
+    for (const auto &entry : sortOrders) {
+        DirectoryScanner::SortOrder order = entry.second;
+        QAction *action = sortMenu->addAction(entry.first);
+        action->setCheckable(true);
+        action->setData(static_cast<int>(order));
+        action->setChecked(order == DirectoryScanner::SortOrder::Name);
+        sortGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [this, order]() { changeSortOrder(order); });
+    }
+
+    QMenu *filterMenu = viewMenu->addMenu("F&ilter");
+    filterMenu->addAction("By &Camera...", this, &MainWindow::filterByCamera);
+    filterMenu->addAction("By &Resolution...", this, &MainWindow::filterByResolution);
+    filterMenu->addAction("&Clear Filter", this, &MainWindow::clearFilter);
+    // filters rebuild the list from the folder, which would silently replace
+    // the duplicate groups being walked
+    connect(viewMenu, &QMenu::aboutToShow, this, [this, filterMenu]() {
+        filterMenu->setEnabled(!duplicateMode);
+    });
+
     //nav menu
     QMenu *navMenu = menuBar()->addMenu("&Navigation");
 
     navMenu->addAction("&Next Image", this, &MainWindow::nextImage, Qt::Key_Right);
 
     navMenu->addAction("&Previous Image", this, &MainWindow::prevImage, Qt::Key_Left);
+
+    navMenu->addSeparator();
+
+    navMenu->addAction("Next &Frame", this, &MainWindow::nextFrame, Qt::Key_PageDown);
+
+    navMenu->addAction("Previous F&rame", this, &MainWindow::prevFrame, Qt::Key_PageUp);
+
+    navMenu->addAction("&Play/Pause", this, &MainWindow::togglePlayback, Qt::Key_Space);
+
+    navMenu->addSeparator();
+
+    navMenu->addAction("Find &Duplicates", this, &MainWindow::findDuplicates, Qt::CTRL | Qt::Key_D);
 }
 
 void MainWindow::setupToolbar()
@@ -121,11 +222,16 @@ void MainWindow::setupToolbar()
 
     toolbar->addAction(redoIcon, "Redo", this, &MainWindow::performRedo);
 }
-void MainWindow::setupEditorPanel()
+void MainWindow::ensureEditorPanel()
 {
-    editorDock = new QDockWidget("Editor", this);
-    editorDock->setAllowedAreas(Qt::RightDockWidgetArea | Qt::LeftDockWidgetArea);
+    if (brightnessSlider)
+        return;
+    setupEditorPanel();
+    StartupProfiler::mark("editor panel built");
+}
 
+void MainWindow::setupEditorPanel()
+{
     QWidget *dockWidget = new QWidget();
     QVBoxLayout *dockLayout = new QVBoxLayout(dockWidget);
 
@@ -135,7 +241,7 @@ void MainWindow::setupEditorPanel()
 
     brightnessSlider = new QSlider(Qt::Horizontal);
     brightnessSlider->setRange(-100, 100);
-    brightnessSlider->setValue(0);
+    brightnessSlider->setValue(pendingLevels.brightness);
     connect(brightnessSlider, &QSlider::valueChanged, this, &MainWindow::onSliderChanged);
     connect(brightnessSlider, &QSlider::sliderReleased, this, &MainWindow::onSliderReleased);
     dockLayout->addWidget(brightnessSlider);
@@ -144,7 +250,7 @@ void MainWindow::setupEditorPanel()
     dockLayout->addWidget(new QLabel("Contrast"));
     contrastSlider = new QSlider(Qt::Horizontal);
     contrastSlider->setRange(0, 30);
-    contrastSlider->setValue(10);
+    contrastSlider->setValue(pendingLevels.contrast);
     connect(contrastSlider, &QSlider::valueChanged, this, &MainWindow::onSliderChanged);
     connect(contrastSlider, &QSlider::sliderReleased, this, &MainWindow::onSliderReleased);
     dockLayout->addWidget(contrastSlider);
@@ -154,7 +260,7 @@ void MainWindow::setupEditorPanel()
     dockLayout->addWidget(new QLabel("Saturation"));
     saturationSlider = new QSlider(Qt::Horizontal);
     saturationSlider->setRange(-100, 100);
-    saturationSlider->setValue(0);
+    saturationSlider->setValue(pendingLevels.saturation);
 
     connect(saturationSlider, &QSlider::valueChanged, this, &MainWindow::onSliderChanged);
     connect(saturationSlider, &QSlider::sliderReleased, this, &MainWindow::onSliderReleased);
@@ -182,6 +288,10 @@ void MainWindow::setupEditorPanel()
     connect(sharpenBtn, &QPushButton::clicked, this, &MainWindow::applySharpen);
     toolLayout->addWidget(sharpenBtn);
 
+    QPushButton *autoBtn = new QPushButton("Auto Enhance");
+    connect(autoBtn, &QPushButton::clicked, this, &MainWindow::autoEnhance);
+    toolLayout->addWidget(autoBtn);
+
     QPushButton *resetBtn = new QPushButton("Reset All");
     connect(resetBtn, &QPushButton::clicked, this, &MainWindow::resetEdits);
     toolLayout->addWidget(resetBtn);
@@ -190,25 +300,27 @@ void MainWindow::setupEditorPanel()
     dockLayout->addStretch();
 
     editorDock->setWidget(dockWidget);
-    addDockWidget(Qt::RightDockWidgetArea, editorDock);
 }
 
 //History logic
 
 void MainWindow::pushUndoState()
 {
+    // committing an edit freezes the animation on the edited frame
+    framePlayer->pause();
 
     // cear the redo stack when a new action is taken
     if (undoIndex < (int)undoHistory.size() - 1)
         undoHistory.resize(undoIndex + 1);
 
     //Store the current display state 
-    undoHistory.push_back(displayMat.clone());
+    undoHistory.push_back({displayMat.clone(), {}});
     undoIndex++;
 
     // Update the base working copy and reset to neutral positions
-    originalMat = displayMat.clone();
+    originalMat = undoHistory.back().image;
     resetSlidersToDefaults();
+    enforceMemoryBudget();
 }
 
 
@@ -223,20 +335,28 @@ void MainWindow::setSliderValueBlocking(QSlider *slider, int value)
 
 void MainWindow::resetSlidersToDefaults()
 {
-    setSliderValueBlocking(brightnessSlider, 0);
-    setSliderValueBlocking(contrastSlider, 10);
-    setSliderValueBlocking(saturationSlider, 0);
+    setAdjustLevels(ImageUtils::AutoLevels());
     setSliderValueBlocking(blurSlider, 0);
     isGrayscale = false;
 }
 
+// without the panel the values wait in pendingLevels; building the panel
+// just for this would undo the deferred startup
+void MainWindow::setAdjustLevels(const ImageUtils::AutoLevels &levels)
+{
+    pendingLevels = levels;
+    setSliderValueBlocking(brightnessSlider, levels.brightness);
+    setSliderValueBlocking(contrastSlider, levels.contrast);
+    setSliderValueBlocking(saturationSlider, levels.saturation);
+}
+
 
 void MainWindow::performUndo()
 {
     if (undoIndex > 0) {
         undoIndex--;
-        originalMat = undoHistory[undoIndex].clone();
-        displayMat = originalMat.clone();
+        originalMat = undoImage(undoIndex);
+        displayMat = originalMat;
         resetSlidersToDefaults();
         onSliderChanged();
     }
@@ -249,36 +369,326 @@ void MainWindow::performRedo()
 {
     if (undoIndex < (int)undoHistory.size() - 1) {
         undoIndex++;
-        originalMat = undoHistory[undoIndex].clone();
-        displayMat = originalMat.clone();
+        originalMat = undoImage(undoIndex);
+        displayMat = originalMat;
         resetSlidersToDefaults();
         onSliderChanged();
     }
 }
 
+cv::Mat MainWindow::undoImage(int index) const
+{
+    const UndoEntry &entry = undoHistory[index];
+    if (!entry.packed.empty())
+        return cv::imdecode(entry.packed, cv::IMREAD_UNCHANGED);
+    return entry.image;
+}
+
+// Memory accounting
+
+void MainWindow::registerMemorySources()
+{
+    MemoryAccountant &memory = MemoryAccountant::instance();
+    using Owner = MemoryAccountant::Owner;
+    using Buffers = std::vector<MemoryAccountant::Buffer>;
+
+    memorySources.push_back(memory.add(Owner::Working, 100, [this](Buffers &out) {
+        out.push_back(MemoryAccountant::buffer("file from disk", cleanMat));
+        out.push_back(MemoryAccountant::buffer("working copy", originalMat));
+    }));
+
+    memorySources.push_back(memory.add(Owner::Display, 90, [this](Buffers &out) {
+        out.push_back(MemoryAccountant::buffer("rendered copy", displayMat));
+        out.push_back({"scene pixmap", &scenePixmapBytes, scene->items().isEmpty() ? 0 : scenePixmapBytes});
+        if (!compareBefore.isNull())
+            out.push_back({"compare pristine render", &compareBefore,
+                           static_cast<size_t>(compareBefore.width()) * compareBefore.height() *
+                               std::max(compareBefore.depth(), 8) / 8});
+    }));
+
+    memorySources.push_back(memory.add(Owner::Undo, 20, [this](Buffers &out) {
+        for (size_t i = 0; i < undoHistory.size(); ++i) {
+            const UndoEntry &entry = undoHistory[i];
+            std::string label = "undo state " + std::to_string(i);
+            if (!entry.packed.empty())
+                out.push_back({label + " (packed)", entry.packed.data(), entry.packed.capacity()});
+            else
+                out.push_back(MemoryAccountant::buffer(label, entry.image));
+        }
+    }, [this](size_t bytes) { return shrinkUndoHistory(bytes); }));
+}
+
+// Free undo memory: PNG-pack the states furthest from the current one
+// (lossless, decoded again on undo) on the thread pool, or when packing
+// could not get under budget anyway, drop the oldest and the redo tail.
+size_t MainWindow::shrinkUndoHistory(size_t bytes)
+{
+    // buffers still shared with the working copies would not be freed
+    auto shared = [this](const UndoEntry &e) {
+        return e.image.data == originalMat.data || e.image.data == cleanMat.data;
+    };
+    auto entryBytes = [&](const UndoEntry &e) -> size_t {
+        if (!e.packed.empty())
+            return e.packed.capacity();
+        return shared(e) ? 0 : e.image.total() * e.image.elemSize();
+    };
+    // fast PNG typically halves a photo; used only to decide whether packing is worth it
+    auto packSaving = [&](const UndoEntry &e) { return entryBytes(e) / 2; };
+
+    std::vector<int> order;
+    for (int i = 0; i < (int)undoHistory.size(); ++i)
+        if (i != undoIndex)
+            order.push_back(i);
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return std::abs(a - undoIndex) > std::abs(b - undoIndex);
+    });
+
+    size_t expected = 0;
+    std::vector<int> toPack;
+    for (int i : order) {
+        const UndoEntry &entry = undoHistory[i];
+        if (entry.packing)
+            expected += packSaving(entry);
+        else if (entry.packed.empty() && !shared(entry) && expected < bytes) {
+            expected += packSaving(entry);
+            toPack.push_back(i);
+        }
+    }
+
+    if (expected >= bytes) {
+        for (int i : toPack) {
+            UndoEntry &entry = undoHistory[i];
+            entry.packing = true;
+            cv::Mat image = entry.image;
+            auto *watcher = new QFutureWatcher<std::vector<uchar>>(this);
+            connect(watcher, &QFutureWatcher<std::vector<uchar>>::finished, this, [this, watcher, image]() {
+                std::vector<uchar> png = watcher->result();
+                watcher->deleteLater();
+                bool ok = !png.empty();
+                // the history may have moved on; find the state by its pixels
+                for (UndoEntry &e : undoHistory) {
+                    if (!e.packing || e.image.data != image.data)
+                        continue;
+                    e.packing = false;
+                    if (ok) {
+                        e.packed = std::move(png);
+                        e.image.release();
+                    }
+                    break;
+                }
+                // re-check in case packing fell short; a failed encode waits for
+                // the next edit rather than being retried straight away
+                if (!ok)
+                    updateStatusBar();
+                else
+                    enforceMemoryBudget();
+            });
+            watcher->setFuture(QtConcurrent::run([image]() {
+                std::vector<uchar> png;
+                if (!cv::imencode(".png", image, png, {cv::IMWRITE_PNG_COMPRESSION, 1}))
+                    png.clear();
+                png.shrink_to_fit();
+                return png;
+            }));
+        }
+        return 0;
+    }
+
+    size_t freed = 0;
+    int dropped = 0;
+    while (freed < bytes && undoIndex > 0) {
+        freed += entryBytes(undoHistory.front());
+        undoHistory.erase(undoHistory.begin());
+        undoIndex--;
+        dropped++;
+    }
+    while (freed < bytes && (int)undoHistory.size() > undoIndex + 1) {
+        freed += entryBytes(undoHistory.back());
+        undoHistory.pop_back();
+        dropped++;
+    }
+    if (dropped)
+        statusBar()->showMessage(QString("Memory budget: dropped %1 undo step(s).").arg(dropped), 5000);
+    return freed;
+}
+
+void MainWindow::enforceMemoryBudget()
+{
+    MemoryAccountant::instance().enforce();
+    updateStatusBar();
+}
+
+void MainWindow::setMemoryBudget()
+{
+    MemoryAccountant &memory = MemoryAccountant::instance();
+    bool ok = false;
+    int mb = QInputDialog::getInt(this, "Memory Budget", "Image memory budget in MB (0 = unlimited):",
+                                  static_cast<int>(memory.budget() / (1024 * 1024)), 0, 1 << 20, 256, &ok);
+    if (!ok)
+        return;
+    memory.setBudget(static_cast<size_t>(mb) * 1024 * 1024);
+    enforceMemoryBudget();
+}
+
+void MainWindow::showMemoryReport()
+{
+    std::string report = MemoryAccountant::instance().report();
+    qInfo().noquote() << QString::fromStdString(report);
+
+    QMessageBox box(this);
+    box.setWindowTitle("Memory Report");
+    box.setText("Image buffers currently held:");
+    box.setDetailedText(QString::fromStdString(report));
+    box.exec();
+}
+
 //Loading & saving
 
-void MainWindow::loadImage(const std::filesystem::path &path)
+void MainWindow::loadImage(const std::filesystem::path &path, const cv::Mat &decoded)
 {
-    cleanMat = cv::imread(path.string());
+    // multi-page and animated files stream through the frame player
+    cv::Mat firstFrame;
+    if (framePlayer->open(path, firstFrame))
+        cleanMat = firstFrame;
+    else
+        cleanMat = decoded.empty() ? ImageLoader::load(path) : decoded;
 
     if (cleanMat.empty())
     {
         statusLabel->setText("Error loading image.");
         return;
     }
+    loadedPath = path;
+    prefetchNeighbours();
     // Reset History
+    startHistory(autoEnhanceOnLoad);
+    enforceMemoryBudget();
+}
+
+// Launch path for a file given on the command line. Both decodes were
+// started before this window was built; the reduced preview (JPEG only)
+// usually lands first and is shown scaled up until the full image arrives.
+void MainWindow::openStartupFile(const std::filesystem::path &path, QFuture<cv::Mat> preview,
+                                 int previewScale, QFuture<cv::Mat> full)
+{
+    statusLabel->setText("Loading " + QString::fromStdString(path.filename().string()) + "...");
+    startupLoading = true;
+
+    if (preview.isValid()) {
+        auto *previewWatcher = new QFutureWatcher<cv::Mat>(this);
+        connect(previewWatcher, &QFutureWatcher<cv::Mat>::finished, this,
+                [this, previewWatcher, previewScale]() {
+            cv::Mat mat = previewWatcher->result();
+            previewWatcher->deleteLater();
+            // too late if the full image already replaced it
+            if (mat.empty() || !cleanMat.empty())
+                return;
+            StartupProfiler::mark("preview decoded");
+            QImage img = ImageUtils::matToQImage(mat);
+            scene->clear();
+            QGraphicsPixmapItem *item = scene->addPixmap(QPixmap::fromImage(img));
+            item->setScale(previewScale);
+            scene->setSceneRect(0, 0, img.width() * previewScale, img.height() * previewScale);
+            updateView();
+        });
+        previewWatcher->setFuture(preview);
+    }
+
+    auto *fullWatcher = new QFutureWatcher<cv::Mat>(this);
+    connect(fullWatcher, &QFutureWatcher<cv::Mat>::finished, this, [this, fullWatcher, path]() {
+        cv::Mat mat = fullWatcher->result();
+        fullWatcher->deleteLater();
+        StartupProfiler::mark("full image decoded");
+        // the directory listing waits until something is on screen
+        if (scanner.openDirectory(path)) {
+            duplicateMode = false;
+            loadImage(scanner.current(), scanner.current() == path ? mat : cv::Mat());
+            startMetadataIndex();
+        } else {
+            statusLabel->setText("Error loading image.");
+        }
+        StartupProfiler::mark("image ready for editing");
+        startupLoading = false;
+        QTimer::singleShot(0, this, &MainWindow::ensureEditorPanel);
+    });
+    fullWatcher->setFuture(full);
+}
+
+// Warm the page cache for the files the user is most likely to open next,
+// so stepping through a folder on slow storage doesn't stall on each key.
+// open() itself can be a server round trip there, so the hints go out from
+// the pool and the key handler returns straight away.
+void MainWindow::prefetchNeighbours()
+{
+    const int ahead = 3;
+    std::vector<std::filesystem::path> paths;
+    for (int i = 1; i <= ahead; ++i)
+        paths.push_back(scanner.peek(i));
+    paths.push_back(scanner.peek(-1));
+
+    (void)QtConcurrent::run([paths]() {
+        for (const auto &p : paths)
+            ImageLoader::prefetch(p);
+    });
+}
+
+void MainWindow::showFrame()
+{
+    cleanMat = framePlayer->current();
+    originalMat = cleanMat;
     undoHistory.clear();
-    originalMat = cleanMat.clone();
-    undoHistory.push_back(originalMat.clone());
+    undoHistory.push_back({originalMat, {}});
     undoIndex = 0;
-    resetEdits();
+    // keep the current slider adjustments applied across frames
+    onSliderChanged();
+}
+
+// showFrame starts a fresh history, so committed edits on this frame
+// (crop, rotate, sharpen) would be lost without asking. The working copy
+// is the frame itself until an edit is committed; undoIndex can't tell,
+// since the memory budget may have trimmed the history down to index 0.
+bool MainWindow::confirmLeaveFrame()
+{
+    if (!framePlayer->isActive() || originalMat.data == cleanMat.data)
+        return true;
+    return QMessageBox::question(this, "Discard Edits",
+                                 "Changing frame discards the edits made to this one. Continue?")
+           == QMessageBox::Yes;
+}
+
+void MainWindow::nextFrame()
+{
+    framePlayer->pause();
+    if (!confirmLeaveFrame())
+        return;
+    framePlayer->step(1);
+}
+
+void MainWindow::prevFrame()
+{
+    framePlayer->pause();
+    if (!confirmLeaveFrame())
+        return;
+    framePlayer->step(-1);
+}
+
+void MainWindow::togglePlayback()
+{
+    if (!framePlayer->isPlaying() && !confirmLeaveFrame())
+        return;
+    framePlayer->togglePlay();
+    updateStatusBar();
 }
 
 void MainWindow::saveFile()
 {
     if (displayMat.empty())
         return;
+    if (framePlayer->isActive()) {
+        QMessageBox::warning(this, "Save", "Saving would replace every page or frame with the one shown. "
+                                           "Use Save As to write this frame to a new file.");
+        return;
+    }
     std::string currentPath = scanner.current().string();
     if (currentPath.empty())
         return;
@@ -315,6 +725,106 @@ void MainWindow::saveAsFile()
     }
 }
 
+// Encode every requested variant in memory on the thread pool and write
+// only the winners; the window stays responsive meanwhile.
+void MainWindow::exportImage()
+{
+    if (displayMat.empty() || exportWatcher->isRunning())
+        return;
+
+    QString base = loadedPath.empty() ? "export" : QString::fromStdString(loadedPath.stem().string());
+    ExportDialog dialog(base, this);
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    std::vector<Exporter::Variant> variants = dialog.variants();
+    std::filesystem::path dir = dialog.outputDir().toStdString();
+    std::string name = dialog.baseName().toStdString();
+    if (variants.empty() || name.empty() || !std::filesystem::is_directory(dir)) {
+        QMessageBox::warning(this, "Export", "Choose at least one format, a name and an existing folder.");
+        return;
+    }
+
+    bool sizeSuffix = std::any_of(variants.begin(), variants.end(),
+                                  [&](const Exporter::Variant &v) { return v.longEdge != variants.front().longEdge; });
+
+    // check every output up front; the defaults can point straight at the
+    // file being viewed, which must never be replaced by a re-encode
+    auto clashes = [&](const std::string &base, bool &original) {
+        bool any = false;
+        original = false;
+        for (const auto &v : variants) {
+            std::filesystem::path file = dir / Exporter::fileName(base, v, sizeSuffix);
+            std::error_code ec;
+            if (!std::filesystem::exists(file, ec))
+                continue;
+            any = true;
+            if (!loadedPath.empty() && std::filesystem::equivalent(file, loadedPath, ec))
+                original = true;
+        }
+        return any;
+    };
+
+    bool original = false;
+    if (clashes(name, original)) {
+        QMessageBox box(QMessageBox::Question, "Export",
+                        original ? "The export would replace the image being viewed."
+                                 : "Some of the exported files already exist.",
+                        QMessageBox::Cancel, this);
+        QPushButton *suffixBtn = box.addButton("Add &Suffix", QMessageBox::AcceptRole);
+        QPushButton *overwriteBtn = original ? nullptr : box.addButton("&Overwrite", QMessageBox::DestructiveRole);
+        box.setDefaultButton(suffixBtn);
+        box.exec();
+
+        if (box.clickedButton() == suffixBtn) {
+            std::string base = name;
+            bool ignored = false;
+            for (int n = 1; clashes(base, ignored); ++n)
+                base = name + "-" + std::to_string(n);
+            name = base;
+        } else if (!overwriteBtn || box.clickedButton() != overwriteBtn) {
+            return;
+        }
+    }
+
+    cv::Mat image = displayMat;
+    size_t target = dialog.targetBytes();
+    statusLabel->setText("Exporting...");
+
+    exportWatcher->setFuture(QtConcurrent::run([image, variants, target, dir, name, sizeSuffix]() {
+        std::vector<Exporter::Result> results = Exporter::encode(image, variants, target);
+
+        QStringList lines;
+        for (const auto &r : results) {
+            std::filesystem::path file = dir / Exporter::fileName(name, r.variant, sizeSuffix);
+
+            QString line = QString::fromStdString(file.filename().string());
+            if (!Exporter::write(file, r)) {
+                lines << line + ": write failed";
+                continue;
+            }
+            line += QString(": %1 KB").arg(r.bytes.size() / 1024);
+            if (r.quality >= 0)
+                line += QString(", quality %1").arg(r.quality);
+            if (!r.metTarget)
+                line += " (over target)";
+            lines << line;
+        }
+        return lines;
+    }));
+}
+
+void MainWindow::onExportFinished()
+{
+    QStringList lines = exportWatcher->result();
+    updateStatusBar();
+    if (lines.isEmpty()) {
+        QMessageBox::critical(this, "Export", "Failed to encode the image.");
+        return;
+    }
+    QMessageBox::information(this, "Export", "Exported:\n" + lines.join("\n"));
+}
+
 //editing
 
 void MainWindow::onSliderChanged()
@@ -322,19 +832,25 @@ void MainWindow::onSliderChanged()
     if (originalMat.empty())
         return;
 
-    cv::Mat result = originalMat.clone();
+    cv::Mat result = originalMat;
 
-    if (saturationSlider->value() != 0)
-        result = ImageUtils::adjustSaturation(result, saturationSlider->value());
+    // sliders don't exist until the editor panel is built; use the pending values
+    int saturation = saturationSlider ? saturationSlider->value() : pendingLevels.saturation;
+    int contrast = contrastSlider ? contrastSlider->value() : pendingLevels.contrast;
+    int brightness = brightnessSlider ? brightnessSlider->value() : pendingLevels.brightness;
+    int blur = blurSlider ? blurSlider->value() : 0;
 
+    if (saturation != 0)
+        result = ImageUtils::adjustSaturation(result, saturation);
 
-    double alpha = contrastSlider->value() / 10.0;
-    int beta = brightnessSlider->value();
+
+    double alpha = contrast / 10.0;
+    int beta = brightness;
     if (alpha != 1.0 || beta != 0)
         result = ImageUtils::adjustBrightnessContrast(result, alpha, beta);
 
-    if (blurSlider->value() > 0)
-        result = ImageUtils::applyBlur(result, blurSlider->value());
+    if (blur > 0)
+        result = ImageUtils::applyBlur(result, blur);
     if (isGrayscale)
         result = ImageUtils::toGrayscale(result);
 
@@ -344,8 +860,11 @@ void MainWindow::onSliderChanged()
     scene->clear();
     scene->addPixmap(QPixmap::fromImage(img));
     scene->setSceneRect(img.rect());
+    scenePixmapBytes = static_cast<size_t>(img.sizeInBytes());
 
     updateView();
+    if (compareView)
+        refreshCompare();
 }
 
 void MainWindow::onSliderReleased()
@@ -384,16 +903,37 @@ void MainWindow::applySharpen()
     onSliderChanged();
 }
 
+// Estimate levels from a subsample and hand them to the sliders, so the
+// result is previewed and committed like any manual adjustment.
+void MainWindow::autoEnhance()
+{
+    if (originalMat.empty())
+        return;
+
+    setAdjustLevels(ImageUtils::estimateAutoLevels(originalMat));
+    onSliderChanged();
+}
+
 void MainWindow::resetEdits()
+{
+    startHistory(false);
+}
+
+// New history on cleanMat, rendered once. With enhance the auto levels are
+// estimated first so loading with auto-enhance doesn't render twice.
+void MainWindow::startHistory(bool enhance)
 {
     if (cleanMat.empty())
         return;
 
+    // the pristine, working and first undo state all share one buffer
     undoHistory.clear();
-    originalMat = cleanMat.clone();
-    undoHistory.push_back(originalMat.clone());
+    originalMat = cleanMat;
+    undoHistory.push_back({originalMat, {}});
     undoIndex = 0;
     resetSlidersToDefaults();
+    if (enhance)
+        setAdjustLevels(ImageUtils::estimateAutoLevels(originalMat));
     onSliderChanged();
 }
 
@@ -401,6 +941,7 @@ void MainWindow::resetEdits()
 
 void MainWindow::toggleCropMode()
 {
+    leaveCompare();
     cropMode = !cropMode;
     if (cropMode) {
         view->setDragMode(QGraphicsView::NoDrag);
@@ -416,6 +957,26 @@ void MainWindow::toggleCropMode()
 
 bool MainWindow::eventFilter(QObject *obj, QEvent *event)
 {
+    if (obj == view->viewport() && event->type() == QEvent::Paint && !editorScheduled) {
+        bool hasImage = !scene->items().isEmpty();
+        if (hasImage)
+            StartupProfiler::mark("first pixel");
+        else if (!firstPaintSeen)
+            StartupProfiler::mark("window painted");
+        firstPaintSeen = true;
+
+        // once the image (or an empty window) is up, build the rest after this paint
+        if (hasImage || !startupLoading) {
+            editorScheduled = true;
+            QTimer::singleShot(0, this, &MainWindow::ensureEditorPanel);
+        }
+    }
+
+    if (compareView && obj == view->viewport() && event->type() == QEvent::Resize) {
+        compareView->setGeometry(view->viewport()->rect());
+        refreshCompare();
+    }
+
     if (!cropMode || obj != view->viewport())
         return QMainWindow::eventFilter(obj, event);
 
@@ -463,15 +1024,20 @@ void MainWindow::openFile()
 {
     QSettings settings("MySoft", "ProImageViewer");
     QString lastDir = settings.value("lastDir", "").toString();
-    QString fileName = QFileDialog::getOpenFileName(this, "Open Image", lastDir, "Images (*.png *.jpg *.jpeg *.bmp *.tif)");
+    QString fileName = QFileDialog::getOpenFileName(this, "Open Image", lastDir, "Images (*.png *.jpg *.jpeg *.bmp *.tif *.tiff *.webp *.gif)");
     if (!fileName.isEmpty())
-    {
-        if (scanner.openDirectory(std::filesystem::path(fileName.toStdString())))
-        {
-            loadImage(scanner.current());
-
-        }
+        openPath(std::filesystem::path(fileName.toStdString()));
+}
 
+void MainWindow::openPath(const std::filesystem::path &path)
+{
+    if (scanner.openDirectory(path))
+    {
+        duplicateMode = false;
+        // a scan still running belongs to the folder we just left
+        duplicateDir.clear();
+        loadImage(scanner.current());
+        startMetadataIndex();
     }
 }
 
@@ -490,8 +1056,163 @@ void MainWindow::prevImage()
         loadImage(p);
 }
 
+// duplicate finder
+
+void MainWindow::findDuplicates()
+{
+    // a second press leaves duplicate mode and restores the full folder
+    if (duplicateMode) {
+        duplicateMode = false;
+        std::filesystem::path p = scanner.current();
+        if (!p.empty() && scanner.openDirectory(p)) {
+            startMetadataIndex();
+            updateStatusBar();
+        }
+        return;
+    }
+
+    if (scanner.files().empty() || duplicateWatcher->isRunning())
+        return;
+
+    statusLabel->setText("Scanning for duplicates...");
+    duplicateDir = scanner.current().parent_path();
+    std::vector<std::filesystem::path> files = scanner.files();
+    duplicateWatcher->setFuture(QtConcurrent::run(IndexCache::pool(), [files]() {
+        return DuplicateFinder().findGroups(files);
+    }));
+}
+
+void MainWindow::onDuplicatesFound()
+{
+    std::vector<DuplicateFinder::Group> groups = duplicateWatcher->result();
+    // the user opened another folder while this one was being scanned
+    if (duplicateDir.empty() || duplicateDir != scanner.current().parent_path())
+        return;
+    duplicateDir.clear();
+    if (groups.empty()) {
+        statusLabel->setText("No duplicates found.");
+        return;
+    }
+
+    // navigate group by group; members of a group are adjacent
+    std::vector<std::filesystem::path> flat;
+    for (const auto& group : groups)
+        flat.insert(flat.end(), group.begin(), group.end());
+
+    QMessageBox::information(this, "Find Duplicates",
+                             QString("Found %1 groups (%2 images). Use Next/Previous to step through them, "
+                                     "and Find Duplicates again to return to the folder.")
+                                 .arg(groups.size())
+                                 .arg(flat.size()));
+
+    scanner.setFiles(std::move(flat));
+    duplicateMode = true;
+    loadImage(scanner.current());
+}
+
+// metadata index, sort & filter
+
+void MainWindow::startMetadataIndex()
+{
+    // the build in flight already covers this folder; a second one would only
+    // repeat the work. A build for another folder finishes in the background
+    // and its result is discarded below.
+    std::filesystem::path dir = scanner.current().parent_path();
+    if (metadataWatcher->isRunning() && dir == metadataDir)
+        return;
+    metadataDir = dir;
+    std::vector<std::filesystem::path> files = scanner.files();
+    metadataWatcher->setFuture(QtConcurrent::run(IndexCache::pool(), [files]() {
+        return MetadataIndex::build(files);
+    }));
+}
+
+void MainWindow::onMetadataReady()
+{
+    std::vector<ImageMetadata> metadata = metadataWatcher->result();
+    if (metadata.empty() || duplicateMode)
+        return;
+
+    // ignore results for a directory we already left
+    if (metadata.front().path.parent_path() != scanner.current().parent_path())
+        return;
+
+    scanner.setMetadata(metadata);
+    updateStatusBar();
+}
+
+void MainWindow::changeSortOrder(DirectoryScanner::SortOrder order)
+{
+    if (duplicateMode)
+        findDuplicates();
+    scanner.setSortOrder(order);
+    updateStatusBar();
+}
+
+void MainWindow::filterByCamera()
+{
+    std::vector<std::string> cameras = scanner.cameras();
+    if (cameras.empty()) {
+        statusLabel->setText("No camera information available.");
+        return;
+    }
+
+    QStringList items{"All Cameras"};
+    for (const auto &c : cameras)
+        items << QString::fromStdString(c);
+
+    bool ok = false;
+    QString choice = QInputDialog::getItem(this, "Filter by Camera", "Camera:", items, 0, false, &ok);
+    if (!ok)
+        return;
+
+    DirectoryScanner::Filter filter = scanner.filter();
+    filter.camera = choice == items.front() ? std::string() : choice.toStdString();
+    scanner.setFilter(filter);
+    showCurrentAfterReorder();
+}
+
+void MainWindow::filterByResolution()
+{
+    bool ok = false;
+    double mp = QInputDialog::getDouble(this, "Filter by Resolution", "Minimum megapixels:",
+                                        scanner.filter().minMegapixels, 0.0, 1000.0, 1, &ok);
+    if (!ok)
+        return;
+
+    DirectoryScanner::Filter filter = scanner.filter();
+    filter.minMegapixels = mp;
+    scanner.setFilter(filter);
+    showCurrentAfterReorder();
+}
+
+void MainWindow::clearFilter()
+{
+    scanner.setFilter(DirectoryScanner::Filter());
+    showCurrentAfterReorder();
+}
+
+// the filter may have hidden the image on screen; show whatever is current now
+void MainWindow::showCurrentAfterReorder()
+{
+    if (duplicateMode)
+        return;
+
+    std::filesystem::path p = scanner.current();
+    if (p.empty()) {
+        QMessageBox::information(this, "Filter", "No images match the filter.");
+        scanner.setFilter(DirectoryScanner::Filter());
+        p = scanner.current();
+    }
+    if (p != loadedPath)
+        loadImage(p);
+    else
+        updateStatusBar();
+}
+
 void MainWindow::zoomIn()
 {
+    leaveCompare();
     fitToWindow = false;
     currentScale *= 1.25;
     updateView();
@@ -500,14 +1221,74 @@ void MainWindow::zoomIn()
 
 void MainWindow::zoomOut()
 {
+    leaveCompare();
     fitToWindow = false;
     currentScale /= 1.25;
     updateView();
     updateStatusBar();
 }
 
+// before/after compare
+
+void MainWindow::toggleCompare()
+{
+    if (compareView) {
+        delete compareView;
+        compareView = nullptr;
+        compareBefore = QPixmap();
+        compareBeforeSource = cv::Mat();
+        return;
+    }
+    if (displayMat.empty())
+        return;
+
+    // the overlay is always fitted and takes every mouse event, so crop and
+    // pan are off while it is up; zoom or crop leave compare mode instead
+    if (cropMode)
+        toggleCropMode();
+    compareView = new CompareView(view->viewport());
+    compareView->setGeometry(view->viewport()->rect());
+    compareView->show();
+    refreshCompare();
+    statusBar()->showMessage("Compare: drag the divider. Press B to return.", 4000);
+}
+
+void MainWindow::leaveCompare()
+{
+    if (compareView)
+        toggleCompare();
+}
+
+// Both sides are fitted to the viewport once. The pristine side is cached
+// until cleanMat or the viewport size changes; the edited side follows
+// displayMat. Dragging the divider never comes back here.
+void MainWindow::refreshCompare()
+{
+    if (!compareView)
+        return;
+
+    qreal dpr = view->viewport()->devicePixelRatioF();
+    QSize bounds = view->viewport()->size() * dpr;
+
+    auto fitted = [&](const cv::Mat &mat) {
+        QPixmap pixmap = QPixmap::fromImage(
+            ImageUtils::matToQImage(ImageUtils::fitWithin(mat, bounds.width(), bounds.height())));
+        pixmap.setDevicePixelRatio(dpr);
+        return pixmap;
+    };
+
+    if (cleanMat.data != compareBeforeSource.data || bounds != compareBeforeBounds) {
+        compareBefore = fitted(cleanMat);
+        compareBeforeSource = cleanMat;
+        compareBeforeBounds = bounds;
+        compareView->setBefore(compareBefore);
+    }
+    compareView->setAfter(fitted(displayMat));
+}
+
 void MainWindow::toggleFitToWindow()
 {
+    leaveCompare();
     fitToWindow = !fitToWindow;
     updateView();
 }
@@ -521,7 +1302,8 @@ void MainWindow::resizeEvent(QResizeEvent *event)
 
 void MainWindow::updateView()
 {
-    if (displayMat.empty())
+    // the scene may hold a startup preview before displayMat exists
+    if (scene->items().isEmpty())
         return;
     if (fitToWindow)
     {
@@ -545,6 +1327,17 @@ void MainWindow::updateStatusBar()
                        .arg(originalMat.cols)
                        .arg(originalMat.rows)
                        .arg(static_cast<int>(currentScale * 100));
+    if (framePlayer->isActive())
+        info += QString(" | %1: %2/%3%4")
+                    .arg(framePlayer->isAnimated() ? "Frame" : "Page")
+                    .arg(framePlayer->currentIndex() + 1)
+                    .arg(framePlayer->frameCount())
+                    .arg(framePlayer->isAnimated() && !framePlayer->isPlaying() ? " (paused)" : "");
+    size_t used = MemoryAccountant::instance().usage();
+    size_t budget = MemoryAccountant::instance().budget();
+    info += QString(" | Mem: %1 MB").arg(used / (1024 * 1024));
+    if (budget)
+        info += QString(" / %1 MB").arg(budget / (1024 * 1024));
     statusLabel->setText(info);
 }
 
@@ -556,6 +1349,14 @@ void MainWindow::loadSettings()
     restoreState(settings.value("windowState").toByteArray());
 
     fitToWindow = settings.value("fitToWindow", true).toBool();
+    autoEnhanceAction->setChecked(settings.value("autoEnhance", false).toBool());
+    MemoryAccountant::instance().setBudget(
+        static_cast<size_t>(settings.value("memoryBudgetMB", 2048).toInt()) * 1024 * 1024);
+
+    int order = settings.value("sortOrder", 0).toInt();
+    scanner.setSortOrder(static_cast<DirectoryScanner::SortOrder>(order));
+    for (QAction *action : sortGroup->actions())
+        action->setChecked(action->data().toInt() == order);
 }
 
 void MainWindow::saveSettings()
@@ -565,6 +1366,9 @@ void MainWindow::saveSettings()
     settings.setValue("windowState", saveState());
 
     settings.setValue("fitToWindow", fitToWindow);
+    settings.setValue("sortOrder", static_cast<int>(scanner.sortOrder()));
+    settings.setValue("autoEnhance", autoEnhanceOnLoad);
+    settings.setValue("memoryBudgetMB", static_cast<int>(MemoryAccountant::instance().budget() / (1024 * 1024)));
 
     if (!scanner.current().empty())
         settings.setValue("lastDir", QString::fromStdString(scanner.current().parent_path().string()));
@@ -9,8 +9,17 @@
 #include <QDockWidget>
 #include <QEvent>
 #include <QRubberBand>
+#include <QPixmap>
+#include <QStringList>
+#include <QFutureWatcher>
+#include <QActionGroup>
 #include <opencv2/opencv.hpp>
 #include "DirectoryScanner.h"
+#include "DuplicateFinder.h"
+#include "FramePlayer.h"
+#include "ImageUtils.h"
+
+class CompareView;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -19,6 +28,10 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // show a file passed on the command line using decodes started in main()
+    void openStartupFile(const std::filesystem::path& path, QFuture<cv::Mat> preview,
+                         int previewScale, QFuture<cv::Mat> full);
+
 protected:
     void closeEvent(QCloseEvent *event) override;
     void resizeEvent(QResizeEvent* event) override;
@@ -28,14 +41,33 @@ private slots:
     void openFile();
     void saveFile();
     void saveAsFile();
+    void exportImage();
+    void onExportFinished();
 
     void nextImage();
     void prevImage();
 
+    void showFrame();
+    void nextFrame();
+    void prevFrame();
+    void togglePlayback();
+
+    void findDuplicates();
+    void onDuplicatesFound();
+
+    void onMetadataReady();
+    void filterByCamera();
+    void filterByResolution();
+    void clearFilter();
+
     void zoomIn();
     void zoomOut();
 
     void toggleFitToWindow();
+    void toggleCompare();
+
+    void setMemoryBudget();
+    void showMemoryReport();
 
     void onSliderReleased(); 
     void onSliderChanged();  
@@ -44,6 +76,7 @@ private slots:
     void toggleGrayscale();
 
     void applySharpen();
+    void autoEnhance();
     void toggleCropMode();
 
     void performUndo();
@@ -53,17 +86,32 @@ private slots:
     void resetSlidersToDefaults();
 
     void setSliderValueBlocking(QSlider* slider, int value);
+    void setAdjustLevels(const ImageUtils::AutoLevels& levels);
+    void startHistory(bool enhance);
 
 private:
-    void loadImage(const std::filesystem::path& path);
+    void loadImage(const std::filesystem::path& path, const cv::Mat& decoded = cv::Mat());
+    void prefetchNeighbours();
     void updateView();
     void updateStatusBar();
     void setupEditorPanel();
+    void ensureEditorPanel();
     void setupToolbar();
     void createMenuBar();
     void loadSettings();
     void saveSettings();
     void pushUndoState();
+    void openPath(const std::filesystem::path& path);
+    void startMetadataIndex();
+    void changeSortOrder(DirectoryScanner::SortOrder order);
+    void showCurrentAfterReorder();
+    bool confirmLeaveFrame();
+    void refreshCompare();
+    void leaveCompare();
+    cv::Mat undoImage(int index) const;
+    void registerMemorySources();
+    size_t shrinkUndoHistory(size_t bytes);
+    void enforceMemoryBudget();
 
     // UI components
     QGraphicsView* view;
@@ -79,9 +127,31 @@ private:
     QSlider* blurSlider;
     
     DirectoryScanner scanner;
-    std::vector<cv::Mat> undoHistory;
+    FramePlayer* framePlayer;
+    QFutureWatcher<std::vector<DuplicateFinder::Group>>* duplicateWatcher;
+    bool duplicateMode;
+    std::filesystem::path duplicateDir;   // folder of the running scan, cleared when it is left
+    QFutureWatcher<std::vector<ImageMetadata>>* metadataWatcher;
+    std::filesystem::path metadataDir;   // folder the watched build is indexing
+    QActionGroup* sortGroup;
+    QFutureWatcher<QStringList>* exportWatcher;
+
+    // Image buffers. No Mat below, in an undo entry or from the frame player
+    // is ever written in place: every edit and adjustment returns a new Mat.
+    // That is what lets cleanMat, originalMat, undo entries and frames share
+    // one buffer, and pool jobs (undo packing, export) read them unlocked.
+    // An in-place operation on any of them must clone first.
+
+    // an undo state; older ones may be PNG-packed to stay within the memory budget
+    struct UndoEntry {
+        cv::Mat image;
+        std::vector<uchar> packed;
+        bool packing = false;   // a PNG encode of image is running on the pool
+    };
+    std::vector<UndoEntry> undoHistory;
     int undoIndex;
     
+    std::filesystem::path loadedPath;
     cv::Mat cleanMat;       // file from disk
     cv::Mat originalMat;    // working copy 
     cv::Mat displayMat;     // rendered copy 
@@ -90,7 +160,22 @@ private:
     double currentScale;
     bool isGrayscale;
     bool cropMode;
+    bool autoEnhanceOnLoad;
+    QAction* autoEnhanceAction;
+    ImageUtils::AutoLevels pendingLevels;   // slider values until the panel is built
     QPoint originCrop;
+
+    // compare mode; null when off
+    CompareView* compareView;
+    QPixmap compareBefore;                // fitted render of cleanMat
+    cv::Mat compareBeforeSource;          // shares cleanMat's buffer so the address can't be reused
+    QSize compareBeforeBounds;
+
+    size_t scenePixmapBytes;
+    std::vector<int> memorySources;     // MemoryAccountant registrations
+    bool firstPaintSeen;
+    bool editorScheduled;
+    bool startupLoading;    // a command-line file is still decoding
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "MemoryAccountant.h"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <set>
+
+MemoryAccountant& MemoryAccountant::instance() {
+    static MemoryAccountant accountant;
+    return accountant;
+}
+
+MemoryAccountant::Buffer MemoryAccountant::buffer(const std::string& label, const cv::Mat& mat) {
+    if (mat.empty()) return {label, nullptr, 0};
+    // datastart..dataend spans the whole allocation, even for ROIs
+    return {label, mat.datastart, static_cast<size_t>(mat.dataend - mat.datastart)};
+}
+
+const char* MemoryAccountant::ownerName(Owner owner) {
+    switch (owner) {
+    case Owner::Working: return "working";
+    case Owner::Display: return "display";
+    case Owner::Undo: return "undo";
+    case Owner::Cache: return "cache";
+    }
+    return "?";
+}
+
+int MemoryAccountant::add(Owner owner, int priority, Reporter report, Shrinker shrink) {
+    int id = nextId++;
+    sources.push_back({id, owner, priority, std::move(report), std::move(shrink)});
+    // keep the most important sources first so shared buffers are charged to them
+    std::stable_sort(sources.begin(), sources.end(),
+                     [](const Source& a, const Source& b) { return a.priority > b.priority; });
+    return id;
+}
+
+void MemoryAccountant::remove(int id) {
+    sources.erase(std::remove_if(sources.begin(), sources.end(),
+                                 [id](const Source& s) { return s.id == id; }),
+                  sources.end());
+}
+
+MemoryAccountant::Tally MemoryAccountant::collect() const {
+    Tally tally;
+    std::set<const void*> seen;
+    std::vector<Buffer> buffers;
+    for (const auto& source : sources) {
+        buffers.clear();
+        source.report(buffers);
+        for (auto& b : buffers) {
+            if (!b.id || b.bytes == 0 || !seen.insert(b.id).second) continue;
+            tally.total += b.bytes;
+            tally.buffers.emplace_back(&source, std::move(b));
+        }
+    }
+    return tally;
+}
+
+size_t MemoryAccountant::usage() const {
+    return collect().total;
+}
+
+size_t MemoryAccountant::enforce() {
+    size_t used = usage();
+    if (budget_ == 0 || used <= budget_) return 0;
+
+    size_t freed = 0;
+    for (auto it = sources.rbegin(); it != sources.rend() && used > budget_; ++it) {
+        if (!it->shrink) continue;
+        freed += it->shrink(used - budget_);
+        // re-tally: releasing a buffer that is still shared elsewhere frees nothing
+        used = usage();
+    }
+    return freed;
+}
+
+std::string MemoryAccountant::report() const {
+    Tally tally = collect();
+    std::map<Owner, size_t> perOwner;
+    for (const auto& [source, b] : tally.buffers) perOwner[source->owner] += b.bytes;
+
+    auto mb = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+    char line[256];
+    std::string out;
+
+    std::snprintf(line, sizeof(line), "Total: %.1f MB", mb(tally.total));
+    out += line;
+    if (budget_) {
+        std::snprintf(line, sizeof(line), " of %.0f MB budget", mb(budget_));
+        out += line;
+    }
+    out += "\n\n";
+
+    for (const auto& [owner, bytes] : perOwner) {
+        std::snprintf(line, sizeof(line), "%-8s %9.1f MB\n", ownerName(owner), mb(bytes));
+        out += line;
+    }
+    out += "\n";
+    for (const auto& [source, b] : tally.buffers) {
+        std::snprintf(line, sizeof(line), "%-8s %9.1f MB  %s\n",
+                      ownerName(source->owner), mb(b.bytes), b.label.c_str());
+        out += line;
+    }
+    return out;
+}
@@ -0,0 +1,69 @@
+#ifndef MEMORY_ACCOUNTANT_H
+#define MEMORY_ACCOUNTANT_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Process-wide tally of large image buffers. Components register a source
+// that lists what they hold, tagged by owner, plus an optional shrink
+// callback. When the total goes over budget, sources are asked to release
+// memory in order of ascending priority. Used from the GUI thread only.
+class MemoryAccountant {
+public:
+    enum class Owner { Working, Display, Undo, Cache };
+
+    struct Buffer {
+        std::string label;
+        const void* id;     // buffers with the same id are counted once
+        size_t bytes;
+    };
+
+    using Reporter = std::function<void(std::vector<Buffer>&)>;
+    // asked to free about `bytes`; returns how much was actually released
+    using Shrinker = std::function<size_t(size_t bytes)>;
+
+    static MemoryAccountant& instance();
+
+    // describe a Mat; shallow copies of the same data share an id
+    static Buffer buffer(const std::string& label, const cv::Mat& mat);
+    static const char* ownerName(Owner owner);
+
+    int add(Owner owner, int priority, Reporter report, Shrinker shrink = nullptr);
+    void remove(int id);
+
+    // 0 means unlimited
+    void setBudget(size_t bytes) { budget_ = bytes; }
+    size_t budget() const { return budget_; }
+
+    size_t usage() const;
+    // shrink sources, lowest priority first, until usage fits the budget
+    size_t enforce();
+    // per-owner totals followed by every buffer, for the debug dump
+    std::string report() const;
+
+private:
+    MemoryAccountant() = default;
+
+    struct Source {
+        int id;
+        Owner owner;
+        int priority;
+        Reporter report;
+        Shrinker shrink;
+    };
+
+    struct Tally {
+        size_t total = 0;
+        std::vector<std::pair<const Source*, Buffer>> buffers;
+    };
+    Tally collect() const;
+
+    std::vector<Source> sources;
+    int nextId = 1;
+    size_t budget_ = 0;
+};
+
+#endif
+//memory accountant
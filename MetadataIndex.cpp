@@ -0,0 +1,283 @@
+#include "MetadataIndex.h"
+#include "IndexCache.h"
+#include <QImageReader>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kIndexMagic = 0x4D564950; // "PIVM"
+constexpr uint32_t kIndexVersion = 1;
+
+// EXIF parsing
+
+// Minimal TIFF/EXIF reader over an in-memory block. Every offset is bounds
+// checked because the data comes straight from untrusted files.
+class TiffReader {
+public:
+    TiffReader(const uint8_t* data, size_t size) : data_(data), size_(size), little_(true) {}
+
+    void parse(ImageMetadata& meta) {
+        if (size_ < 8) return;
+        if (data_[0] == 'I' && data_[1] == 'I') little_ = true;
+        else if (data_[0] == 'M' && data_[1] == 'M') little_ = false;
+        else return;
+        if (u16(2) != 42) return;
+
+        std::string make, model, dateTime, dateOriginal;
+        uint32_t exifOffset = 0;
+        readIfd(u32(4), [&](uint16_t tag, uint16_t type, uint32_t count, size_t valuePos) {
+            if (tag == 0x010F) make = ascii(type, count, valuePos);
+            else if (tag == 0x0110) model = ascii(type, count, valuePos);
+            else if (tag == 0x0132) dateTime = ascii(type, count, valuePos);
+            else if (tag == 0x8769) exifOffset = u32(valuePos);
+        });
+        if (exifOffset) {
+            readIfd(exifOffset, [&](uint16_t tag, uint16_t type, uint32_t count, size_t valuePos) {
+                if (tag == 0x9003) dateOriginal = ascii(type, count, valuePos);
+            });
+        }
+
+        meta.dateTaken = parseDate(dateOriginal.empty() ? dateTime : dateOriginal);
+        // most vendors repeat the make in the model ("Canon" / "Canon EOS R5")
+        if (!model.empty() && model.compare(0, make.size(), make) == 0) meta.camera = model;
+        else if (!make.empty() && !model.empty()) meta.camera = make + " " + model;
+        else meta.camera = make + model;
+    }
+
+private:
+    template <typename Fn>
+    void readIfd(uint32_t offset, Fn&& visit) {
+        if (offset + 2 > size_) return;
+        uint16_t entries = u16(offset);
+        for (uint16_t i = 0; i < entries; ++i) {
+            size_t pos = offset + 2 + i * 12;
+            if (pos + 12 > size_) return;
+            visit(u16(pos), u16(pos + 2), u32(pos + 4), pos + 8);
+        }
+    }
+
+    std::string ascii(uint16_t type, uint32_t count, size_t valuePos) {
+        if (type != 2 || count == 0) return {};
+        size_t start = count <= 4 ? valuePos : u32(valuePos);
+        if (start >= size_ || count > size_ - start) return {};
+        std::string s(reinterpret_cast<const char*>(data_ + start), count);
+        s.erase(std::find(s.begin(), s.end(), '\0'), s.end());
+        while (!s.empty() && s.back() == ' ') s.pop_back();
+        return s;
+    }
+
+    // "YYYY:MM:DD HH:MM:SS" -> YYYYMMDDhhmmss, which sorts chronologically
+    static long long parseDate(const std::string& s) {
+        if (s.size() < 19) return 0;
+        long long value = 0;
+        for (char c : s.substr(0, 19)) {
+            if (c >= '0' && c <= '9') value = value * 10 + (c - '0');
+        }
+        return value;
+    }
+
+    uint16_t u16(size_t pos) const {
+        if (pos + 2 > size_) return 0;
+        return little_ ? uint16_t(data_[pos] | data_[pos + 1] << 8)
+                       : uint16_t(data_[pos] << 8 | data_[pos + 1]);
+    }
+
+    uint32_t u32(size_t pos) const {
+        if (pos + 4 > size_) return 0;
+        return little_ ? uint32_t(u16(pos)) | uint32_t(u16(pos + 2)) << 16
+                       : uint32_t(u16(pos)) << 16 | uint32_t(u16(pos + 2));
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    bool little_;
+};
+
+// Walk JPEG markers up to the first scan; only the APP1 payload is read.
+void readJpegExif(std::ifstream& in, ImageMetadata& meta) {
+    uint8_t soi[2];
+    if (!in.read(reinterpret_cast<char*>(soi), 2) || soi[0] != 0xFF || soi[1] != 0xD8) return;
+
+    while (in) {
+        uint8_t marker[4];
+        if (!in.read(reinterpret_cast<char*>(marker), 4) || marker[0] != 0xFF) return;
+        if (marker[1] == 0xDA || marker[1] == 0xD9) return; // start of scan / end of image
+        size_t length = size_t(marker[2]) << 8 | marker[3];
+        if (length < 2) return;
+        length -= 2;
+
+        if (marker[1] == 0xE1 && length > 6) {
+            std::vector<uint8_t> app1(length);
+            if (!in.read(reinterpret_cast<char*>(app1.data()), length)) return;
+            if (std::memcmp(app1.data(), "Exif\0\0", 6) == 0) {
+                TiffReader(app1.data() + 6, app1.size() - 6).parse(meta);
+                return;
+            }
+        } else {
+            in.seekg(static_cast<std::streamoff>(length), std::ios::cur);
+        }
+    }
+}
+
+// TIFF files are EXIF containers themselves; the IFDs we need sit near the start.
+void readTiffExif(std::ifstream& in, ImageMetadata& meta) {
+    std::vector<uint8_t> head(256 * 1024);
+    in.read(reinterpret_cast<char*>(head.data()), head.size());
+    head.resize(static_cast<size_t>(in.gcount()));
+    TiffReader(head.data(), head.size()).parse(meta);
+}
+
+// Cache
+
+// Columnar layout: magic, version, count, then one column per field
+// (names, mtime, size, width, height, date, camera id) and the camera table.
+template <typename T>
+void writeColumn(std::ofstream& out, const std::vector<ImageMetadata>& rows, T ImageMetadata::*field) {
+    std::vector<T> column;
+    column.reserve(rows.size());
+    for (const auto& row : rows) column.push_back(row.*field);
+    out.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+template <typename T>
+void readColumn(std::ifstream& in, std::vector<ImageMetadata>& rows, T ImageMetadata::*field) {
+    std::vector<T> column(rows.size());
+    in.read(reinterpret_cast<char*>(column.data()), column.size() * sizeof(T));
+    for (size_t i = 0; i < rows.size(); ++i) rows[i].*field = column[i];
+}
+
+void writeString(std::ofstream& out, const std::string& s) {
+    uint16_t len = static_cast<uint16_t>(std::min<size_t>(s.size(), UINT16_MAX));
+    out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+    out.write(s.data(), len);
+}
+
+std::string readString(std::ifstream& in) {
+    uint16_t len = 0;
+    in.read(reinterpret_cast<char*>(&len), sizeof(len));
+    std::string s(len, '\0');
+    in.read(s.data(), len);
+    return s;
+}
+
+std::vector<ImageMetadata> readIndex(const fs::path& file, const fs::path& dir) {
+    std::ifstream in(file, std::ios::binary);
+    uint32_t count = 0;
+    // empty name plus every fixed-size column and the camera id
+    constexpr size_t kMinRow = sizeof(uint16_t) + 3 * sizeof(long long) + 2 * sizeof(int) + sizeof(uint32_t);
+    if (!in || !IndexCache::readHeader(in, kIndexMagic, kIndexVersion, kMinRow, count)) return {};
+
+    std::vector<ImageMetadata> rows(count);
+    for (auto& row : rows) row.path = dir / readString(in);
+    readColumn(in, rows, &ImageMetadata::mtime);
+    readColumn(in, rows, &ImageMetadata::fileSize);
+    readColumn(in, rows, &ImageMetadata::width);
+    readColumn(in, rows, &ImageMetadata::height);
+    readColumn(in, rows, &ImageMetadata::dateTaken);
+
+    uint32_t cameraCount = 0;
+    in.read(reinterpret_cast<char*>(&cameraCount), sizeof(cameraCount));
+    if (!in || !IndexCache::fits(in, cameraCount, sizeof(uint16_t))) return {};
+    std::vector<std::string> cameras(cameraCount);
+    for (auto& c : cameras) c = readString(in);
+    std::vector<uint32_t> cameraIds(count);
+    in.read(reinterpret_cast<char*>(cameraIds.data()), cameraIds.size() * sizeof(uint32_t));
+    if (!in) return {}; // truncated file, treat as no cache
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (cameraIds[i] < cameras.size()) rows[i].camera = cameras[cameraIds[i]];
+    }
+    return rows;
+}
+
+void writeIndex(const fs::path& file, const std::vector<ImageMetadata>& rows) {
+    IndexCache::write(file, kIndexMagic, kIndexVersion, static_cast<uint32_t>(rows.size()),
+                      [&rows](std::ofstream& out) {
+        for (const auto& row : rows) writeString(out, row.path.filename().string());
+        writeColumn(out, rows, &ImageMetadata::mtime);
+        writeColumn(out, rows, &ImageMetadata::fileSize);
+        writeColumn(out, rows, &ImageMetadata::width);
+        writeColumn(out, rows, &ImageMetadata::height);
+        writeColumn(out, rows, &ImageMetadata::dateTaken);
+
+        // camera names repeat across thousands of files, so store each once
+        std::vector<std::string> cameras;
+        std::map<std::string, uint32_t> cameraIds;
+        std::vector<uint32_t> ids;
+        ids.reserve(rows.size());
+        for (const auto& row : rows) {
+            auto [it, inserted] = cameraIds.emplace(row.camera, static_cast<uint32_t>(cameras.size()));
+            if (inserted) cameras.push_back(row.camera);
+            ids.push_back(it->second);
+        }
+        uint32_t cameraCount = static_cast<uint32_t>(cameras.size());
+        out.write(reinterpret_cast<const char*>(&cameraCount), sizeof(cameraCount));
+        for (const auto& c : cameras) writeString(out, c);
+        out.write(reinterpret_cast<const char*>(ids.data()), ids.size() * sizeof(uint32_t));
+    });
+}
+
+} // namespace
+
+bool MetadataIndex::read(const fs::path& path, ImageMetadata& meta) {
+    std::error_code ec;
+    meta.path = path;
+    meta.mtime = IndexCache::modifiedTime(path);
+    meta.fileSize = static_cast<long long>(fs::file_size(path, ec));
+    if (ec) return false;
+
+    // QImageReader::size() only parses the header, it never decodes pixels
+    QImageReader reader(QString::fromStdString(path.string()));
+    QSize size = reader.size();
+    meta.width = size.isValid() ? size.width() : 0;
+    meta.height = size.isValid() ? size.height() : 0;
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext == ".jpg" || ext == ".jpeg") readJpegExif(in, meta);
+    else if (ext == ".tif" || ext == ".tiff") readTiffExif(in, meta);
+    return true;
+}
+
+std::vector<ImageMetadata> MetadataIndex::build(const std::vector<fs::path>& files) {
+    if (files.empty()) return {};
+    fs::path dir = files.front().parent_path();
+    fs::path cacheFile = IndexCache::pathFor(dir, "meta");
+
+    std::unordered_map<std::string, ImageMetadata> cached;
+    for (auto& row : readIndex(cacheFile, dir)) {
+        std::string name = row.path.filename().string();
+        cached.emplace(std::move(name), std::move(row));
+    }
+
+    std::vector<ImageMetadata> rows(files.size());
+    std::vector<ImageMetadata*> pending;
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto hit = cached.find(files[i].filename().string());
+        if (hit != cached.end() && hit->second.mtime == IndexCache::modifiedTime(files[i])) {
+            rows[i] = std::move(hit->second);
+        } else {
+            rows[i].path = files[i];
+            pending.push_back(&rows[i]);
+        }
+    }
+
+    QtConcurrent::blockingMap(IndexCache::pool(), pending, [](ImageMetadata* meta) {
+        read(meta->path, *meta);
+    });
+
+    // rewrite when anything was refreshed or files disappeared
+    if (!pending.empty() || cached.size() != files.size())
+        writeIndex(cacheFile, rows);
+    return rows;
+}
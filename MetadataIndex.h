@@ -0,0 +1,32 @@
+#ifndef METADATA_INDEX_H
+#define METADATA_INDEX_H
+
+#include <vector>
+#include <filesystem>
+#include <string>
+
+// Header-level facts about an image; nothing here needs a pixel decode
+struct ImageMetadata {
+    std::filesystem::path path;
+    long long mtime = -1;
+    long long fileSize = 0;
+    int width = 0;
+    int height = 0;
+    long long dateTaken = 0;   // EXIF DateTimeOriginal as YYYYMMDDhhmmss, 0 if unknown
+    std::string camera;        // EXIF make/model, empty if unknown
+};
+
+// Builds and persists per-directory metadata so sorting and filtering never
+// has to touch the image files again on a repeat visit
+class MetadataIndex {
+public:
+    // Load the cached index for the files' directory, refresh stale or missing
+    // entries on the thread pool and write the cache back when anything changed.
+    static std::vector<ImageMetadata> build(const std::vector<std::filesystem::path>& files);
+
+    // read size, dimensions and EXIF for a single file; false if unreadable
+    static bool read(const std::filesystem::path& path, ImageMetadata& meta);
+};
+
+#endif
+//metadata index
@@ -0,0 +1,45 @@
+#ifndef STARTUP_PROFILER_H
+#define STARTUP_PROFILER_H
+
+#include <QElapsedTimer>
+#include <QDebug>
+
+// Timestamps the launch path for --startup-profile. The clock starts at the
+// top of main() so every milestone is relative to process start-up.
+class StartupProfiler {
+public:
+    static void start() {
+        state().clock.start();
+    }
+
+    static void setEnabled(bool enabled) {
+        state().enabled = enabled;
+    }
+
+    static bool isEnabled() {
+        return state().enabled;
+    }
+
+    // print a milestone; cheap no-op unless profiling was requested
+    static void mark(const char* milestone) {
+        State& s = state();
+        if (!s.enabled) return;
+        qInfo().noquote() << QString("[startup] %1 ms  %2")
+                                 .arg(s.clock.nsecsElapsed() / 1e6, 8, 'f', 1)
+                                 .arg(milestone);
+    }
+
+private:
+    struct State {
+        QElapsedTimer clock;
+        bool enabled = false;
+    };
+
+    static State& state() {
+        static State s;
+        return s;
+    }
+};
+
+#endif
+//startup profiler
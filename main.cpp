@@ -1,15 +1,59 @@
 #include "MainWindow.h"
+#include "ImageLoader.h"
+#include "StartupProfiler.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QImageReader>
+#include <QScreen>
+#include <QtConcurrent>
 
 int main(int argc, char *argv[]) {
+    StartupProfiler::start();
     QApplication app(argc, argv);
     
     app.setOrganizationName("MySoft");
     app.setApplicationName("ImageViewer");
     app.setStyle("Fusion");
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", "Image to open.");
+    QCommandLineOption profileOption("startup-profile", "Print launch timings to stderr.");
+    parser.addOption(profileOption);
+    parser.process(app);
+
+    StartupProfiler::setEnabled(parser.isSet(profileOption));
+    StartupProfiler::mark("application ready");
+
+    // start decoding the file before any widget exists; the window picks
+    // the results up when it is ready
+    std::filesystem::path startupFile;
+    QFuture<cv::Mat> preview, full;
+    int previewScale = 1;
+    if (!parser.positionalArguments().isEmpty()) {
+        startupFile = std::filesystem::absolute(parser.positionalArguments().first().toStdString());
+        full = QtConcurrent::run([startupFile]() { return ImageLoader::load(startupFile); });
+
+        QSize imageSize = QImageReader(QString::fromStdString(startupFile.string())).size();
+        QScreen *screen = app.primaryScreen();
+        QSize screenSize = screen ? screen->availableSize() * screen->devicePixelRatio() : QSize();
+        previewScale = ImageLoader::previewScale(startupFile,
+                                                 cv::Size(imageSize.width(), imageSize.height()),
+                                                 cv::Size(screenSize.width(), screenSize.height()));
+        if (previewScale > 1) {
+            preview = QtConcurrent::run([startupFile, previewScale]() {
+                return ImageLoader::loadReduced(startupFile, previewScale);
+            });
+        }
+        StartupProfiler::mark("decode started");
+    }
+
     MainWindow window;
+    StartupProfiler::mark("window constructed");
+    if (!startupFile.empty())
+        window.openStartupFile(startupFile, preview, previewScale, full);
     window.show();
+    StartupProfiler::mark("window shown");
 
     return app.exec();
-}
\ No newline at end of file
+}